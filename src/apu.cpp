@@ -4,6 +4,12 @@
 
 Apu::Apu()
 {
+	ClearPadding(pulse);
+	ClearPadding(triangle);
+	ClearPadding(noise);
+	ClearPadding(dmc);
+	noise.lfsr = 1;
+
 	for(uint8_t x = 0; x < 31; ++x)
 	{
 		// mixer.pulse[x] = std::round((95.52 / (8128.0 / x+100)) * 255.0); //8-bit
@@ -338,31 +344,43 @@ void Apu::Tick()
 			nearestCounter = 0;
 			++outI &= 0b11111;
 
-			uint8_t pulseOutput = 0;
-			for(const auto &p : pulse)
+			if(!skipAudio) //mixing only reads channel state, so it can be left out
 			{
-				if(p.duty & p.dutyCounter && p.lengthCounter && !SweepForcingSilence(p))
+				uint8_t pulseOutput = 0;
+				for(const auto &p : pulse)
 				{
-					pulseOutput += (p.constant) ? p.volume : p.envelopeVolume;
+					if(p.duty & p.dutyCounter && p.lengthCounter && !SweepForcingSilence(p))
+					{
+						pulseOutput += (p.constant) ? p.volume : p.envelopeVolume;
+					}
 				}
-			}
 
-			const uint8_t triangleOutput = (ultrasonic) ? 7 : triangleSequencerTable[triangle.sequencerStep]; //should be 7.5. HMM set to 0?
+				const uint8_t triangleOutput = (ultrasonic) ? 7 : triangleSequencerTable[triangle.sequencerStep]; //should be 7.5. HMM set to 0?
 
-			uint8_t noiseOutput = 0;
-			if(!(noise.lfsr & 1) && noise.lengthCounter)
-			{
-				noiseOutput = (noise.constant) ? noise.volume : noise.envelopeVolume;
-			}
+				uint8_t noiseOutput = 0;
+				if(!(noise.lfsr & 1) && noise.lengthCounter)
+				{
+					noiseOutput = (noise.constant) ? noise.volume : noise.envelopeVolume;
+				}
 
-			const float output = mixer.pulse[pulseOutput] + mixer.tnd[triangleOutput * 3 + noiseOutput * 2 + dmc.output];
-			apuSamples[sampleCount * 2] = output;
-			apuSamples[sampleCount * 2 + 1] = output;
-			++sampleCount;
+				float output = mixer.pulse[pulseOutput] + mixer.tnd[triangleOutput * 3 + noiseOutput * 2 + dmc.output];
+				if(expansion.chip)
+				{
+					output += expansion.Output();
+				}
+				apuSamples[sampleCount * 2] = output;
+				apuSamples[sampleCount * 2 + 1] = output;
+				++sampleCount;
+			}
 		}
 	}
 	apuTick = !apuTick;
 
+	if(expansion.chip)
+	{
+		expansion.Tick();
+	}
+
 	IncrementSequencer();
 }
 
@@ -379,6 +397,26 @@ const bool Apu::PollFrameInterrupt() const
 }
 
 
+const uint16_t Apu::FrameInterruptDelay() const //ticks the sequencer can run without touching frameIRQ
+{
+	if(sequencerResetDelay)
+	{
+		return 0;
+	}
+
+	//frameIRQ is only ever changed by sequencer steps 29828-29830
+	if(sequencerCounter <= 29828)
+	{
+		return 29828 - sequencerCounter;
+	}
+	else if(sequencerCounter > 29830 && sequencerMode == 1)
+	{
+		return 37282 - sequencerCounter + 29828;
+	}
+	return 0;
+}
+
+
 void Apu::IncrementSequencer()
 {
 	if(sequencerResetDelay & 1)
@@ -539,3 +577,23 @@ bool Apu::SweepForcingSilence(const Pulse &p) const
 	}
 	return !p.sweepNegate & (p.freqTimer + (p.freqTimer >> p.sweepShift) >> 11); //if freqTimer >= 0x800
 }
+
+
+void Apu::Serialize(State &state)
+{
+	state.Data(pulse);
+	state.Data(triangle);
+	state.Data(noise);
+	state.Data(dmc);
+	state.Data(frameCounter);
+	state.Data(blockIRQ);
+	state.Data(frameIRQ);
+	state.Data(sequencerCounter);
+	state.Data(sequencerMode);
+	state.Data(sequencerResetDelay);
+	state.Data(apuTick);
+	state.Data(nearestCounter);
+	state.Data(outI);
+	state.Data(dmcDma);
+	expansion.Serialize(state);
+}
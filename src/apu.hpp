@@ -4,6 +4,8 @@
 #include <array>
 #include <vector>
 
+#include "expansion.hpp"
+#include "state.hpp"
 
 struct Pulse
 {
@@ -85,10 +87,16 @@ class Apu
 
 		const void* const GetOutput() const;
 		uint16_t sampleCount = 0;
+		bool skipAudio = false; //no mixing or samples, channel state still runs
 
 		const bool PollFrameInterrupt() const;
+		const uint16_t FrameInterruptDelay() const;
 		bool dmcDma = false;
 
+		ExpansionAudio expansion; //cartridge sound chip, mixed in when present
+
+		void Serialize(State &state);
+
 	private:
 		void IncrementSequencer();
 		void QuarterFrame();
@@ -97,7 +105,7 @@ class Apu
 
 		std::array<Pulse, 2> pulse{};
 		Triangle triangle{};
-		Noise noise{1};
+		Noise noise{};
 		Dmc dmc{};
 		Mixer mixer;
 
@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "nes.hpp"
+#include "video.hpp"
+
+
+//synthetic workloads for the hot paths, each a rom built here so results don't depend on what's on disk.
+//reports the best of a few runs in ns per emulated cpu cycle, compare them commit to commit on one machine
+struct Workload
+{
+	const char *name;
+	const char *description;
+	uint8_t mapper;
+	uint8_t prgBanks; //16kb
+	std::vector<uint8_t> reset, nmi, irq; //at $E010, $E100 and $E180
+};
+
+//sei, cld, ldx #$ff, txs, then wait two vblanks, at $E000
+const std::vector<uint8_t> prologue
+{
+	0x78, 0xD8, 0xA2, 0xFF, 0x9A, 0x2C, 0x02, 0x20, 0x10, 0xFB, 0x2C, 0x02, 0x20, 0x10, 0xFB, 0xEA
+};
+
+const std::vector<Workload> workloads
+{
+	{
+		"alu", "adc, eor and zero page/indexed stores in a tight loop, rendering off", 0, 1,
+		{
+			0x18,             //loop: clc
+			0x69, 0x03,       //adc #$03
+			0x45, 0x10,       //eor $10
+			0x85, 0x10,       //sta $10
+			0x0A,             //asl a
+			0xE6, 0x11,       //inc $11
+			0xA6, 0x11,       //ldx $11
+			0x9D, 0x00, 0x03, //sta $0300,x
+			0x88,             //dey
+			0xD0, 0xEE,       //bne loop
+			0x4C, 0x10, 0xE0  //jmp loop
+		},
+		{0x40}, {0x40}
+	},
+	{
+		"sprites", "64 sprites, 8 on most lines from 65 to 134, oam dma every frame", 0, 1,
+		{
+			0xA2, 0x00,       //ldx #0
+			0xA0, 0x00,       //ldy #0
+			0x98,             //oam: tya
+			0x18,             //clc
+			0x69, 0x40,       //adc #64
+			0x9D, 0x00, 0x02, //sta $0200,x
+			0x98,             //tya
+			0x9D, 0x01, 0x02, //sta $0201,x
+			0x29, 0x03,       //and #3
+			0x9D, 0x02, 0x02, //sta $0202,x
+			0x98,             //tya
+			0x0A,             //asl a
+			0x0A,             //asl a
+			0x9D, 0x03, 0x02, //sta $0203,x
+			0xE8,             //inx
+			0xE8,             //inx
+			0xE8,             //inx
+			0xE8,             //inx
+			0xC8,             //iny
+			0xC0, 0x40,       //cpy #64
+			0xD0, 0xE1,       //bne oam
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x00, 0x20, //sta $2000
+			0xA9, 0x1E,       //lda #$1e
+			0x8D, 0x01, 0x20, //sta $2001
+			0x4C, 0x3D, 0xE0  //jmp *
+		},
+		{
+			0xA9, 0x02,       //lda #$02
+			0x8D, 0x14, 0x40, //sta $4014
+			0x40              //rti
+		},
+		{0x40}
+	},
+	{
+		"flip", "the sprites workload with every sprite flipped both ways", 0, 1,
+		{
+			0xA2, 0x00,       //ldx #0
+			0xA0, 0x00,       //ldy #0
+			0x98,             //oam: tya
+			0x18,             //clc
+			0x69, 0x40,       //adc #64
+			0x9D, 0x00, 0x02, //sta $0200,x
+			0x98,             //tya
+			0x9D, 0x01, 0x02, //sta $0201,x
+			0x29, 0x03,       //and #3
+			0x09, 0xC0,       //ora #$c0, flip h and v
+			0x9D, 0x02, 0x02, //sta $0202,x
+			0x98,             //tya
+			0x0A,             //asl a
+			0x0A,             //asl a
+			0x9D, 0x03, 0x02, //sta $0203,x
+			0xE8,             //inx
+			0xE8,             //inx
+			0xE8,             //inx
+			0xE8,             //inx
+			0xC8,             //iny
+			0xC0, 0x40,       //cpy #64
+			0xD0, 0xDF,       //bne oam
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x00, 0x20, //sta $2000
+			0xA9, 0x1E,       //lda #$1e
+			0x8D, 0x01, 0x20, //sta $2001
+			0x4C, 0x3F, 0xE0  //jmp *
+		},
+		{
+			0xA9, 0x02,       //lda #$02
+			0x8D, 0x14, 0x40, //sta $4014
+			0x40              //rti
+		},
+		{0x40}
+	},
+	{
+		"dmc", "all channels on, dmc looping at the fastest rate", 0, 1,
+		{
+			0xA9, 0xBF, 0x8D, 0x00, 0x40, //pulse 1
+			0xA9, 0x40, 0x8D, 0x02, 0x40,
+			0xA9, 0x01, 0x8D, 0x03, 0x40,
+			0xA9, 0xFF, 0x8D, 0x08, 0x40, //triangle
+			0xA9, 0x80, 0x8D, 0x0A, 0x40,
+			0xA9, 0x00, 0x8D, 0x0B, 0x40,
+			0xA9, 0x3F, 0x8D, 0x0C, 0x40, //noise
+			0xA9, 0x03, 0x8D, 0x0E, 0x40,
+			0x8D, 0x0F, 0x40,
+			0xA9, 0x4F, 0x8D, 0x10, 0x40, //dmc loop, rate $f
+			0xA9, 0x00, 0x8D, 0x12, 0x40, //from $c000
+			0xA9, 0xFF, 0x8D, 0x13, 0x40, //4081 bytes
+			0xA9, 0x1F, 0x8D, 0x15, 0x40,
+			0xE6, 0x10,                   //loop: inc $10
+			0x4C, 0x4F, 0xE0              //jmp loop
+		},
+		{0x40}, {0x40}
+	},
+	{
+		"oamdmc", "back to back oam dma with rendering on, the dmc stealing cycles at its fastest rate", 0, 1,
+		{
+			0xA9, 0x1E, 0x8D, 0x01, 0x20, //rendering on
+			0xA9, 0x4F, 0x8D, 0x10, 0x40, //dmc loop, rate $f
+			0xA9, 0x00, 0x8D, 0x12, 0x40,
+			0xA9, 0xFF, 0x8D, 0x13, 0x40,
+			0xA9, 0x10, 0x8D, 0x15, 0x40,
+			0xA9, 0x02,                   //loop: lda #$02
+			0x8D, 0x14, 0x40,             //sta $4014
+			0x4C, 0x29, 0xE0              //jmp loop
+		},
+		{0x40}, {0x40}
+	},
+	{
+		"mmc3", "rendering with the mmc3 irq latch at 7, each irq changing the scroll", 4, 2,
+		{
+			0xA9, 0x40,       //lda #$40, no frame irq
+			0x8D, 0x17, 0x40, //sta $4017
+			0xA9, 0x88,       //lda #$88, nmi, sprites from $1000
+			0x8D, 0x00, 0x20, //sta $2000
+			0xA9, 0x1E,       //lda #$1e
+			0x8D, 0x01, 0x20, //sta $2001
+			0xA9, 0x07,       //lda #7
+			0x8D, 0x00, 0xC0, //sta $c000
+			0x8D, 0x01, 0xC0, //sta $c001
+			0x8D, 0x01, 0xE0, //sta $e001
+			0x58,             //cli
+			0x4C, 0x2B, 0xE0  //jmp *
+		},
+		{
+			0x48,             //pha
+			0xA9, 0x00,       //lda #0
+			0x8D, 0x05, 0x20, //sta $2005
+			0x8D, 0x05, 0x20, //sta $2005
+			0x68,             //pla
+			0x40              //rti
+		},
+		{
+			0x48,             //pha
+			0x8D, 0x00, 0xE0, //sta $e000
+			0x8D, 0x01, 0xE0, //sta $e001
+			0xE6, 0x10,       //inc $10
+			0xA5, 0x10,       //lda $10
+			0x8D, 0x05, 0x20, //sta $2005
+			0x8D, 0x05, 0x20, //sta $2005
+			0x68,             //pla
+			0x40              //rti
+		}
+	},
+	{
+		"mmc3cpu", "the alu loop on an mmc3 with rendering off, what the irq scheduler lets sleep", 4, 2,
+		{
+			0x18,             //loop: clc
+			0x69, 0x03,       //adc #$03
+			0x45, 0x10,       //eor $10
+			0x85, 0x10,       //sta $10
+			0x0A,             //asl a
+			0xE6, 0x11,       //inc $11
+			0xA6, 0x11,       //ldx $11
+			0x9D, 0x00, 0x03, //sta $0300,x
+			0x88,             //dey
+			0xD0, 0xEE,       //bne loop
+			0x4C, 0x10, 0xE0  //jmp loop
+		},
+		{0x40}, {0x40}
+	},
+	{
+		"mmc1", "serial writes to the mmc1 prg and chr bank registers, rendering off", 1, 2,
+		{
+			0xA5, 0x10,       //loop: lda $10
+			0x29, 0x01,       //and #1
+			0x8D, 0x00, 0xE0, //sta $e000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xE0, //sta $e000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xE0, //sta $e000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xE0, //sta $e000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xE0, //sta $e000
+			0xA5, 0x10,       //lda $10
+			0x8D, 0x00, 0xA0, //sta $a000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xA0, //sta $a000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xA0, //sta $a000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xA0, //sta $a000
+			0x4A,             //lsr a
+			0x8D, 0x00, 0xA0, //sta $a000
+			0xE6, 0x10,       //inc $10
+			0x4C, 0x10, 0xE0  //jmp loop
+		},
+		{0x40}, {0x40}
+	},
+	{
+		"mmc5", "extended attributes, the vertical split and a scanline irq while rendering, the multiplier in the main loop", 5, 2,
+		{
+			0xA9, 0x40,       //lda #$40, no frame irq
+			0x8D, 0x17, 0x40, //sta $4017
+			0xA9, 0x01,       //lda #$01
+			0x8D, 0x04, 0x51, //sta $5104, exram as extended attributes
+			0xA9, 0xD0,       //lda #$d0
+			0x8D, 0x00, 0x52, //sta $5200, split right of tile 16
+			0xA9, 0x64,       //lda #100
+			0x8D, 0x03, 0x52, //sta $5203, irq on line 100
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x04, 0x52, //sta $5204
+			0xA9, 0x88,       //lda #$88
+			0x8D, 0x00, 0x20, //sta $2000
+			0xA9, 0x1E,       //lda #$1e
+			0x8D, 0x01, 0x20, //sta $2001
+			0x58,             //cli
+			0xA5, 0x10,       //loop: lda $10
+			0x8D, 0x05, 0x52, //sta $5205
+			0x8D, 0x06, 0x52, //sta $5206
+			0xAD, 0x05, 0x52, //lda $5205
+			0x6D, 0x06, 0x52, //adc $5206
+			0x85, 0x10,       //sta $10
+			0x4C, 0x34, 0xE0  //jmp loop
+		},
+		{0x40},
+		{
+			0x48,             //pha
+			0xAD, 0x04, 0x52, //lda $5204, acknowledge
+			0xE6, 0x11,       //inc $11
+			0xA5, 0x11,       //lda $11
+			0x8D, 0x01, 0x52, //sta $5201, split y scroll
+			0x68,             //pla
+			0x40              //rti
+		}
+	},
+	{
+		"vrc6", "both pulses and the saw playing, the cycle irq every 256 cycles, rendering off", 24, 2,
+		{
+			0xA9, 0x40,       //lda #$40, no frame irq
+			0x8D, 0x17, 0x40, //sta $4017
+			0xA9, 0x3F,       //lda #$3f
+			0x8D, 0x00, 0x90, //sta $9000, pulse 1, duty 3, volume 15
+			0xA9, 0x40,       //lda #$40
+			0x8D, 0x01, 0x90, //sta $9001
+			0xA9, 0x81,       //lda #$81
+			0x8D, 0x02, 0x90, //sta $9002
+			0xA9, 0x5F,       //lda #$5f
+			0x8D, 0x00, 0xA0, //sta $a000, pulse 2
+			0xA9, 0x20,       //lda #$20
+			0x8D, 0x01, 0xA0, //sta $a001
+			0xA9, 0x82,       //lda #$82
+			0x8D, 0x02, 0xA0, //sta $a002
+			0xA9, 0x0A,       //lda #$0a
+			0x8D, 0x00, 0xB0, //sta $b000, saw
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x01, 0xB0, //sta $b001
+			0x8D, 0x02, 0xB0, //sta $b002
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0xF0, //sta $f000, irq latch 0, every 256 cycles
+			0xA9, 0x07,       //lda #$07
+			0x8D, 0x01, 0xF0, //sta $f001, cycle mode, enabled, again after acknowledge
+			0x58,             //cli
+			0xE6, 0x10,       //loop: inc $10
+			0x4C, 0x4B, 0xE0  //jmp loop
+		},
+		{0x40},
+		{
+			0x8D, 0x02, 0xF0, //sta $f002, acknowledge
+			0x40              //rti
+		}
+	},
+	{
+		"fme7", "three 5b tones playing, the irq counter reloaded for every 256 cycles, rendering off", 69, 2,
+		{
+			0xA9, 0x40,       //lda #$40, no frame irq
+			0x8D, 0x17, 0x40, //sta $4017
+			0xA9, 0x07,       //lda #$07
+			0x8D, 0x00, 0xC0, //sta $c000
+			0xA9, 0x38,       //lda #$38
+			0x8D, 0x00, 0xE0, //sta $e000, 5b tones a, b and c on
+			0xA9, 0x08,       //lda #$08
+			0x8D, 0x00, 0xC0, //sta $c000
+			0xA9, 0x0F,       //lda #$0f
+			0x8D, 0x00, 0xE0, //sta $e000, channel a volume
+			0xA9, 0x09,       //lda #$09
+			0x8D, 0x00, 0xC0, //sta $c000
+			0x8D, 0x00, 0xE0, //sta $e000, channel b volume
+			0xA9, 0x0A,       //lda #$0a
+			0x8D, 0x00, 0xC0, //sta $c000
+			0x8D, 0x00, 0xE0, //sta $e000, channel c volume
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0xC0, //sta $c000
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x00, 0xE0, //sta $e000, channel a period
+			0xA9, 0x0D,       //lda #$0d
+			0x8D, 0x00, 0x80, //sta $8000, the parameter register stays on irq control
+			0xA9, 0x81,       //lda #$81
+			0x8D, 0x00, 0xA0, //sta $a000, irq and counter on
+			0x58,             //cli
+			0xE6, 0x10,       //loop: inc $10
+			0x4C, 0x4E, 0xE0  //jmp loop
+		},
+		{0x40},
+		{
+			0x48,             //pha
+			0xA9, 0x0E,       //lda #$0e
+			0x8D, 0x00, 0x80, //sta $8000
+			0xA9, 0xFF,       //lda #$ff
+			0x8D, 0x00, 0xA0, //sta $a000, counter low, 256 cycles to the next one
+			0xA9, 0x0F,       //lda #$0f
+			0x8D, 0x00, 0x80, //sta $8000
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0xA0, //sta $a000, counter high
+			0xA9, 0x0D,       //lda #$0d
+			0x8D, 0x00, 0x80, //sta $8000
+			0xA9, 0x81,       //lda #$81
+			0x8D, 0x00, 0xA0, //sta $a000, acknowledge
+			0x68,             //pla
+			0x40              //rti
+		}
+	},
+	{
+		"n163", "all 8 wavetable channels playing, the irq counter reloaded for every 255 cycles, rendering off", 19, 2,
+		{
+			0xA9, 0x40,       //lda #$40, no frame irq
+			0x8D, 0x17, 0x40, //sta $4017
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0xE0, //sta $e000, sound on
+			0xA9, 0x80,       //lda #$80
+			0x8D, 0x00, 0xF8, //sta $f800, sound ram from 0, auto increment
+			0xA2, 0x00,       //ldx #$00
+			0x8A,             //fill: txa
+			0x49, 0x5A,       //eor #$5a
+			0x8D, 0x00, 0x48, //sta $4800, waves and channel registers
+			0xE8,             //inx
+			0x10, 0xF7,       //bpl fill
+			0xA9, 0x7F,       //lda #$7f
+			0x8D, 0x00, 0xF8, //sta $f800
+			0x8D, 0x00, 0x48, //sta $4800, 8 channels
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0x50, //sta $5000
+			0xA9, 0xFF,       //lda #$ff
+			0x8D, 0x00, 0x58, //sta $5800, irq in 255 cycles
+			0x58,             //cli
+			0xE6, 0x10,       //loop: inc $10
+			0x4C, 0x3D, 0xE0  //jmp loop
+		},
+		{0x40},
+		{
+			0x48,             //pha
+			0xA9, 0x00,       //lda #$00
+			0x8D, 0x00, 0x50, //sta $5000, acknowledge and count again
+			0xA9, 0xFF,       //lda #$ff
+			0x8D, 0x00, 0x58, //sta $5800
+			0x68,             //pla
+			0x40              //rti
+		}
+	}
+};
+
+
+//the core only loads roms from files
+static const std::string WriteRom(const Workload &workload)
+{
+	std::vector<uint8_t> prg(workload.prgBanks * 0x4000, 0x55); //also the dmc's sample
+	const size_t base = prg.size() - 0x2000;
+	std::copy(prologue.begin(), prologue.end(), prg.begin() + base);
+	std::copy(workload.reset.begin(), workload.reset.end(), prg.begin() + base + prologue.size());
+	std::copy(workload.nmi.begin(), workload.nmi.end(), prg.begin() + base + 0x100);
+	std::copy(workload.irq.begin(), workload.irq.end(), prg.begin() + base + 0x180);
+	const std::array<uint8_t, 6> vectors{{0x00, 0xE1, 0x00, 0xE0, 0x80, 0xE1}};
+	std::copy(vectors.begin(), vectors.end(), prg.end() - 6);
+
+	std::vector<uint8_t> chr(0x2000);
+	for(size_t x = 0; x < chr.size(); ++x)
+	{
+		chr[x] = x * 0x9D >> 3; //something in every tile
+	}
+
+	const std::array<uint8_t, 16> header{{'N', 'E', 'S', 0x1A, workload.prgBanks, 1, uint8_t(workload.mapper << 4), uint8_t(workload.mapper & 0xF0)}};
+	const std::string path = std::string("nesbench_") + workload.name + ".nes";
+	std::ofstream output(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	output.write(reinterpret_cast<const char*>(header.data()), header.size());
+	output.write(reinterpret_cast<const char*>(prg.data()), prg.size());
+	output.write(reinterpret_cast<const char*>(chr.data()), chr.size());
+	if(!output.good())
+	{
+		std::cout << "Could not write " << path << std::endl;
+		exit(1);
+	}
+	return path;
+}
+
+
+static std::unique_ptr<Nes> Load(const Workload &workload)
+{
+	const std::string path = WriteRom(workload);
+	std::unique_ptr<Nes> nes(new Nes(path, BatteryOff));
+	std::remove(path.c_str());
+	if(!nes->Loaded())
+	{
+		exit(1);
+	}
+
+	for(int x = 0; x < 10; ++x) //past the vblank waits and setup
+	{
+		nes->AdvanceFrame(0, 0);
+		nes->apu.sampleCount = 0;
+	}
+	return nes;
+}
+
+
+int main(int argc, char* argv[])
+{
+	uint32_t frames = 600;
+	uint32_t repeats = 5;
+	std::string only;
+	for(int x = 1; x < argc; ++x)
+	{
+		const std::string option = argv[x];
+		if(option == "-f" && x + 1 < argc)
+		{
+			frames = std::max(1ul, std::stoul(argv[++x]));
+		}
+		else if(option == "-r" && x + 1 < argc)
+		{
+			repeats = std::max(1ul, std::stoul(argv[++x]));
+		}
+		else if(option[0] != '-' && only.empty())
+		{
+			only = option;
+		}
+		else
+		{
+			std::cout << "nesbench [-f frames] [-r repeats] [workload]" << std::endl;
+			std::cout << "  workloads: ";
+			for(const auto &w : workloads)
+			{
+				std::cout << w.name << " ";
+			}
+			std::cout << "ppu apu video" << std::endl;
+			exit(0);
+		}
+	}
+
+	char line[160];
+	for(const auto &workload : workloads)
+	{
+		if(!only.empty() && only != workload.name)
+		{
+			continue;
+		}
+
+		std::unique_ptr<Nes> nes = Load(workload);
+		double best = 1e30;
+		for(uint32_t r = 0; r < repeats; ++r)
+		{
+			const uint32_t startCycle = nes->GetInfo().cycles;
+			const auto t1 = std::chrono::steady_clock::now();
+			for(uint32_t f = 0; f < frames; ++f)
+			{
+				nes->AdvanceFrame(0, 0);
+				nes->apu.sampleCount = 0; //what the audio output does every frame
+			}
+			const auto t2 = std::chrono::steady_clock::now();
+			const uint32_t cycles = nes->GetInfo().cycles - startCycle;
+			best = std::min(best, std::chrono::duration<double, std::nano>(t2 - t1).count() / cycles);
+		}
+		std::snprintf(line, sizeof(line), "%-8s %7.2f ns/cycle %7.0f fps  %s", workload.name, best, 1e9 / (best * 29780.5), workload.description);
+		std::cout << line << std::endl;
+	}
+
+	//the units alone, driven without the cpu on a machine already set up by a workload
+	auto isolated = [&](const char *name, const char *unit, const Workload &workload, const uint32_t ticksPerFrame, void (*tick)(Nes &nes))
+	{
+		if(!only.empty() && only != name)
+		{
+			return;
+		}
+		std::unique_ptr<Nes> nes = Load(workload);
+		double best = 1e30;
+		for(uint32_t r = 0; r < repeats; ++r)
+		{
+			const auto t1 = std::chrono::steady_clock::now();
+			for(uint32_t f = 0; f < frames; ++f)
+			{
+				for(uint32_t x = 0; x < ticksPerFrame; ++x)
+				{
+					tick(*nes);
+				}
+				nes->apu.sampleCount = 0;
+			}
+			const auto t2 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t2 - t1).count() / (double(frames) * ticksPerFrame));
+		}
+		std::snprintf(line, sizeof(line), "%-8s %7.2f ns/%s", name, best, unit);
+		std::cout << line << std::endl;
+	};
+	isolated("ppu", "dot  ", workloads[1] /*sprites*/, 341 * 262, [](Nes &nes){ nes.ppu.Tick(); });
+	isolated("apu", "cycle", workloads[3] /*dmc*/, 29781, [](Nes &nes){ nes.apu.Tick(); });
+
+	//the indexed frame's conversion to rgba, IndexedToRgba against the scalar table lookup
+	if(only.empty() || only == "video")
+	{
+		std::unique_ptr<Nes> nes = Load(workloads[1] /*sprites*/);
+		nes->ppu.SetPixelFormat(Indexed);
+		nes->AdvanceFrame(0, 0);
+		const uint8_t *indices = nes->ppu.GetIndexPtr();
+		const uint8_t *lineEmphasis = nes->ppu.GetEmphasisPtr();
+		const uint32_t *paletteLut = nes->ppu.GetPaletteLut();
+		std::vector<uint32_t> kernel(256 * 240), lookup(256 * 240);
+		double bestKernel = 1e30, bestLookup = 1e30;
+		for(uint32_t r = 0; r < repeats; ++r)
+		{
+			const auto t1 = std::chrono::steady_clock::now();
+			for(uint32_t f = 0; f < frames; ++f)
+			{
+				IndexedToRgba(indices, lineEmphasis, paletteLut, kernel.data());
+				asm volatile("" : : "r"(kernel.data()) : "memory"); //every frame is written, not just the last
+			}
+			const auto t2 = std::chrono::steady_clock::now();
+			for(uint32_t f = 0; f < frames; ++f)
+			{
+				for(uint32_t y = 0; y < 240; ++y) //what the kernel falls back to without avx2
+				{
+					const uint32_t *lut = paletteLut + (lineEmphasis[y] << 6);
+					for(uint32_t x = y * 256; x < y * 256 + 256; ++x)
+					{
+						lookup[x] = lut[indices[x]];
+					}
+				}
+				asm volatile("" : : "r"(lookup.data()) : "memory");
+			}
+			const auto t3 = std::chrono::steady_clock::now();
+			bestKernel = std::min(bestKernel, std::chrono::duration<double, std::micro>(t2 - t1).count() / frames);
+			bestLookup = std::min(bestLookup, std::chrono::duration<double, std::micro>(t3 - t2).count() / frames);
+		}
+		std::snprintf(line, sizeof(line), "%-8s %7.2f us/frame, %.2f with the scalar lookup%s", "video", bestKernel, bestLookup, (kernel == lookup) ? "" : ", OUTPUT DIFFERS");
+		std::cout << line << std::endl;
+	}
+
+	return 0;
+}
@@ -8,26 +8,30 @@
 #include "sha1.hpp"
 
 
-Cart::Cart(const std::string inFile, std::vector<uint8_t> &prgRom, std::vector<uint8_t> &prgRam) : prgRom(prgRom), prgRam(prgRam)
+Cart::Cart(const std::string inFile, std::vector<uint8_t> &prgRom, SaveFile &prgRam, const BatteryMode battery) : prgRom(prgRom), prgRam(prgRam), savePath(SavePath(inFile)), battery(battery)
 {
 	fileContent = FileToU8Vec(inFile);
+	if(fileContent.empty()) //already reported
+	{
+		return;
+	}
 	if(fileContent.size() < 512) //just some number
 	{
-		std::cout << "File is too small to be a nes rom\n";
-		exit(0);
+		std::cout << inFile << " is too small to be a nes rom\n";
+		return;
 	}
 
 	//ines header
 	std::copy_n(fileContent.begin(), 16, header.begin());
-	if(header[0] != 0x4E && header[1] != 0x45 && header[2] != 0x53 && header[3] != 0x1A)
+	if(header[0] != 0x4E || header[1] != 0x45 || header[2] != 0x53 || header[3] != 0x1A)
 	{
-		std::cout << "Not a valid .nes file" << std::endl;
-		exit(0);
+		std::cout << inFile << " is not a valid .nes file" << std::endl;
+		return;
 	}
 	fileContent.erase(fileContent.begin(), fileContent.begin() + 0x10);
 
 
-	const std::array<uint32_t, 5> sha1 = SHA1(fileContent);
+	sha1 = SHA1(fileContent);
 	if(cartInfo.count(sha1))
 	{
 		GameInfoSha(sha1);
@@ -43,25 +47,39 @@ Cart::Cart(const std::string inFile, std::vector<uint8_t> &prgRom, std::vector<u
 			case 2: type = UNROM; break;
 			case 3: type = CNROM; break;
 			case 4: type = TGROM; break;
+			case 5: type = EKROM; break;
 			case 7: type = AOROM; break;
+			case 9: type = PNROM; break;
+			case 10: type = FKROM; break;
+			case 19: type = N_163; break;
 			case 21: type = VRC_4; break;
-		}
-
+			case 24: type = VRC_6a; break;
+			case 26: type = VRC_6b; break;
+			case 69: type = JLROM; break;
 
-		if(mapper == 0 || mapper == 1 || mapper == 2 || mapper == 3 || mapper == 4 || mapper == 7)
+			default:
+				std::cout << inFile << " has unsupported mapper " << +mapper << std::endl;
+				return;
+		}
+		if(header[4] == 0 || (mapper == 7 && header[4] < 2)) //the default banks need one 16kb bank, aorom's 32kb
 		{
-			prgRom.assign(fileContent.begin(), fileContent.begin() + header[4] * 0x4000);
-			SetDefaultPrgBanks(prgRom);
-
-			SetChrMem(fileContent);
-			SetDefaultNametableLayout();
+			std::cout << inFile << " has an unsupported prg rom size of " << header[4] * 16 << "kb" << std::endl;
+			return;
 		}
-		else
+		if(fileContent.size() < size_t(header[4] * 0x4000 + header[5] * 0x2000))
 		{
-			std::cout << "unsupported mapper\n" << +mapper;
-			exit(0);
+			std::cout << inFile << " is shorter than its header says" << std::endl;
+			return;
 		}
+
+		prgRom.assign(fileContent.begin(), fileContent.begin() + header[4] * 0x4000);
+		SetDefaultPrgBanks(prgRom);
+		SetDefaultPrgRam();
+
+		SetChrMem(fileContent);
+		SetDefaultNametableLayout();
 	}
+	loaded = true;
 }
 
 
@@ -77,7 +95,7 @@ void Cart::GameInfoSha(std::array<uint32_t, 5> sha1)
 
 	if(attr.wram)
 	{
-		prgRam.resize(attr.wram * 1024);
+		SetPrgRam(attr.wram, attr.wramBattery);
 
 		for(int x = 0; x < 4; ++x)
 		{
@@ -122,45 +140,85 @@ void Cart::SetDefaultPrgBanksSha(std::vector<uint8_t> &prgRom, cartAttributes at
 			pPrgBank[2] = prgRom.data() + 0x4000;
 			pPrgBank[3] = prgRom.data() + 0x6000;
 		break;
+
+		default: //the other boards aren't in the database, they only come in through ines headers
+		break;
 	}
 }
 
 
-void Cart::SetDefaultPrgBanks(std::vector<uint8_t> &prgRom)
+void Cart::SetDefaultPrgBanks(std::vector<uint8_t> &prgRom) //mappers with other layouts fix them up in Nes::MapperInit
 {
-	if(mapper == 0 || mapper == 1 || mapper == 2 || mapper == 3 || mapper == 4 || mapper == 21)
+	if(mapper == 7)
 	{
 		pPrgBank[0] = &prgRom[0];
 		pPrgBank[1] = &prgRom[0x2000];
-		pPrgBank[2] = &prgRom[(header[4] - 1) * 0x4000];
-		pPrgBank[3] = pPrgBank[2] + 0x2000;
+		pPrgBank[2] = &prgRom[0x4000];
+		pPrgBank[3] = &prgRom[0x6000];
 	}
-	else if(mapper == 7)
+	else
 	{
 		pPrgBank[0] = &prgRom[0];
 		pPrgBank[1] = &prgRom[0x2000];
-		pPrgBank[2] = &prgRom[0x4000];
-		pPrgBank[3] = &prgRom[0x6000];
+		pPrgBank[2] = &prgRom[(header[4] - 1) * 0x4000];
+		pPrgBank[3] = pPrgBank[2] + 0x2000;
 	}
 }
 
 
-void Cart::SetChrMem(const std::vector<uint8_t> &fileContent)
+void Cart::SetDefaultPrgRam()
 {
-	if(mapper == 0 || mapper == 1 || mapper == 2 || mapper == 3 || mapper == 4)
+	//no reliable size in ines 1.0 headers, so give the boards that usually have wram the common amount
+	uint16_t wram = 0;
+	switch(mapper)
+	{
+		case 5: wram = 32; break; //mmc5 banks it in 8kb pages
+		case 10: case 19: case 24: case 26: case 69: wram = 8; break;
+		case 0: case 1: case 4: wram = 8; break; //test roms report their results there, boards without it leave the range open anyway
+		default:
+			if(header[6] & 0b10) //a battery means there is something to back up
+			{
+				wram = 8;
+			}
+		break;
+	}
+
+	if(wram)
 	{
-		if(header[5])
-		{
-			chrMem.assign(fileContent.begin() + header[4] * 0x4000, fileContent.begin() + header[4] * 0x4000 + header[5] * 0x2000);
-			chrType = ChrRom;
-		}
-		else
+		SetPrgRam(wram, header[6] & 0b10);
+		for(int x = 0; x < 4; ++x)
 		{
-			chrMem.resize(0x2000);
-			chrType = ChrRam;
+			pPrgRamBank[x] = prgRam.data() + x * 2048;
 		}
 	}
-	else if(mapper == 7)
+}
+
+
+void Cart::SetPrgRam(const uint16_t size, const bool hasBattery)
+{
+	if(hasBattery && battery == BatteryFile)
+	{
+		prgRam.Map(savePath, size * 1024);
+	}
+	else if(hasBattery && battery == BatteryCopy)
+	{
+		prgRam.Copy(savePath, size * 1024);
+	}
+	else
+	{
+		prgRam.Resize(size * 1024);
+	}
+}
+
+
+void Cart::SetChrMem(const std::vector<uint8_t> &fileContent)
+{
+	if(header[5] && mapper != 7)
+	{
+		chrMem.assign(fileContent.begin() + header[4] * 0x4000, fileContent.begin() + header[4] * 0x4000 + header[5] * 0x2000);
+		chrType = ChrRom;
+	}
+	else
 	{
 		chrMem.resize(0x2000);
 		chrType = ChrRam;
@@ -170,18 +228,7 @@ void Cart::SetChrMem(const std::vector<uint8_t> &fileContent)
 
 void Cart::SetDefaultNametableLayout()
 {
-	if(mapper == 0 || mapper == 2 || mapper == 3)
-	{
-		if(header[6] & 1)
-		{
-			nametableOffsets = {A, B, A, B}; //horizontal arrangement
-		}
-		else
-		{
-			nametableOffsets = {A, A, B, B}; //vertical arrangement
-		}
-	}
-	else if(mapper == 4)
+	if(mapper == 4)
 	{
 		nametableOffsets = {A, A, B, B}; //vertical arrangement
 	}
@@ -189,4 +236,12 @@ void Cart::SetDefaultNametableLayout()
 	{
 		nametableOffsets = {A, A, A, A}; // single screen
 	}
+	else if(header[6] & 1)
+	{
+		nametableOffsets = {A, B, A, B}; //horizontal arrangement
+	}
+	else
+	{
+		nametableOffsets = {A, A, B, B}; //vertical arrangement
+	}
 }
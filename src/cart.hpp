@@ -3,6 +3,7 @@
 #include <map>
 
 #include "ppu.hpp"
+#include "savefile.hpp"
 
 
 enum System : uint8_t {Ntsc = 0, Pal = 1};
@@ -13,8 +14,15 @@ enum Type : uint16_t
     UNROM = 2,
     CNROM = 3,
     TGROM = 4, TKROM = 4, TLROM = 4, TSROM = 4,
+    EKROM = 5, ELROM = 5, ETROM = 5, EWROM = 5,
     AOROM = 7,
-    VRC_4 = 21
+    PNROM = 9,
+    FJROM = 10, FKROM = 10,
+    N_163 = 19,
+    VRC_4 = 21,
+    VRC_6a = 24,
+    VRC_6b = 26,
+    JLROM = 69, JSROM = 69
 };
 enum NametableLayout : uint8_t {vertical = 1, horizontal = 2, single = 3};
 enum Extra : uint8_t {none = 0, VRC4e = 1, MMC1A = 1, MMC1B2 = 2, MMC1B3 = 3, MMC3B = 4};
@@ -36,14 +44,16 @@ struct cartAttributes
 struct Cart
 {
     public:
-        Cart(const std::string inFile, std::vector<uint8_t> &prgRom, std::vector<uint8_t> &prgRam);
+        Cart(const std::string inFile, std::vector<uint8_t> &prgRom, SaveFile &prgRam, const BatteryMode battery = BatteryFile);
 
         std::array<uint8_t, 16> header;
+        std::array<uint32_t, 5> sha1;
         uint8_t mapper = 0xFF;
         Type type;
+        bool loaded = false; //the file was read and its board is supported, nothing else is set up otherwise
 
         std::array<uint8_t*, 4> pPrgBank;
-        std::array<uint8_t*, 4> pPrgRamBank;
+        std::array<uint8_t*, 4> pPrgRamBank{};
 
         std::vector<uint8_t> chrMem;
         bool chrType;
@@ -54,12 +64,16 @@ struct Cart
         void GameInfoSha(std::array<uint32_t, 5> sha1);
         void SetDefaultPrgBanksSha(std::vector<uint8_t> &prgRom, cartAttributes attr);
         void SetDefaultPrgBanks(std::vector<uint8_t> &prgRom);
+        void SetDefaultPrgRam();
+        void SetPrgRam(const uint16_t size, const bool hasBattery);
         void SetChrMem(const std::vector<uint8_t> &fileContent);
         void SetDefaultNametableLayout();
 
         std::vector<uint8_t> fileContent;
         std::vector<uint8_t> &prgRom;
-        std::vector<uint8_t> &prgRam;
+        SaveFile &prgRam;
+        const std::string savePath;
+        const BatteryMode battery;
 
         //can't map multiple keys to the same value, maybe fix
         const std::map<std::array<uint32_t, 5>, cartAttributes> cartInfo
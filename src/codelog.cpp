@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "codelog.hpp"
+
+
+void CodeLogger::Resize(const size_t prgSize, const size_t chrSize)
+{
+	if(prg.size() != prgSize || chr.size() != chrSize)
+	{
+		prg.assign(prgSize, 0);
+		chr.assign(chrSize, 0);
+		for(auto &count : counts)
+		{
+			count.assign(prgSize, 0);
+		}
+	}
+}
+
+
+void CodeLogger::Clear()
+{
+	std::fill(prg.begin(), prg.end(), 0);
+	std::fill(chr.begin(), chr.end(), 0);
+	for(auto &count : counts)
+	{
+		std::fill(count.begin(), count.end(), 0);
+	}
+}
+
+
+const uint8_t CodeLogger::InstructionLength(const uint8_t opcode) //bytes including the opcode, illegal ones too
+{
+	const bool odd = opcode & 0x10;
+	switch(opcode & 0x0F)
+	{
+		case 0x0: return odd ? 2 : (opcode == 0x20) ? 3 : (opcode >= 0x80 || opcode == 0x00) ? 2 : 1; //brk skips a byte
+		case 0x2: return (!odd && opcode >= 0x80) ? 2 : 1;
+		case 0x8: case 0xA: return 1;
+		case 0x9: case 0xB: return odd ? 3 : 2;
+		case 0xC: case 0xD: case 0xE: case 0xF: return 3;
+		default: return 2;
+	}
+}
+
+
+bool CodeLogger::SaveCdl(const std::string &path) const
+{
+	std::ofstream output(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!output.is_open())
+	{
+		std::cout << "Could not create " << path << std::endl;
+		return false;
+	}
+
+	output.write(reinterpret_cast<const char*>(prg.data()), prg.size());
+	output.write(reinterpret_cast<const char*>(chr.data()), chr.size());
+	return output.good();
+}
+
+
+bool CodeLogger::SaveHeatmap(const std::string &path) const
+{
+	std::ofstream output(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!output.is_open())
+	{
+		std::cout << "Could not create " << path << std::endl;
+		return false;
+	}
+
+	//log scale, anything touched at all stands out from what never was
+	auto shade = [](const uint64_t count) -> uint8_t
+	{
+		return count ? std::min(255.0, 64 + std::log2(double(count)) * 8) : 0;
+	};
+
+	const size_t rows = (prg.size() + 255) / 256;
+	output << "P6\n256 " << rows << "\n255\n";
+	std::vector<uint8_t> pixels(rows * 256 * 3, 0);
+	for(size_t x = 0; x < prg.size(); ++x)
+	{
+		pixels[x * 3 + 0] = shade(counts[AccessWrite][x]);
+		pixels[x * 3 + 1] = shade(counts[AccessExec][x]);
+		pixels[x * 3 + 2] = shade(counts[AccessRead][x]);
+	}
+	output.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	return output.good();
+}
+
+
+const std::vector<std::array<uint64_t, 3>> CodeLogger::BankTotals(const size_t bankSize) const
+{
+	std::vector<std::array<uint64_t, 3>> totals((prg.size() + bankSize - 1) / bankSize);
+	for(size_t x = 0; x < prg.size(); ++x)
+	{
+		for(uint8_t access = 0; access < 3; ++access)
+		{
+			totals[x / bankSize][access] += counts[access][x];
+		}
+	}
+	return totals;
+}
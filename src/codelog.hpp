@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+//fceux's .cdl bits, prg bytes also keep the $8000 window they were last used in at bits 2-3
+enum CdlFlag : uint8_t {CdlCode = 0x01, CdlData = 0x02, CdlPcm = 0x40};
+enum CdlChrFlag : uint8_t {CdlChrRead = 0x02};
+enum CdlAccess : uint8_t {AccessExec = 0, AccessRead = 1, AccessWrite = 2};
+
+//marks prg bytes as code or data and counts every access to them, filled by the cpu core's debug variant.
+//each access is an or and an increment, nothing is looked up
+class CodeLogger
+{
+	public:
+		void Resize(const size_t prgSize, const size_t chrSize); //keeps what's logged if the rom is the same size
+		void Clear();
+
+		static const uint8_t InstructionLength(const uint8_t opcode);
+		void LogPrg(const uint32_t offset, const uint8_t flags, const CdlAccess access)
+		{
+			prg[offset] = (prg[offset] & ~0b1100) | flags;
+			++counts[access][offset];
+		}
+		void LogChr(const uint32_t offset)
+		{
+			chr[offset] |= CdlChrRead;
+		}
+
+		bool SaveCdl(const std::string &path) const;     //prg flags then chr flags, loads in fceux
+		bool SaveHeatmap(const std::string &path) const; //ppm, 256 bytes a row and 32 rows an 8kb bank. red writes, green execs, blue reads
+		const std::vector<std::array<uint64_t, 3>> BankTotals(const size_t bankSize = 0x2000) const; //accesses per bank by CdlAccess
+
+	private:
+		std::vector<uint8_t> prg, chr;
+		std::array<std::vector<uint64_t>, 3> counts;
+};
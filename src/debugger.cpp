@@ -0,0 +1,364 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "debugger.hpp"
+
+
+bool Debugger::Add(const Breakpoint &breakpoint)
+{
+	Expression condition;
+	if(!breakpoint.condition.empty() && !Compile(breakpoint.condition, condition))
+	{
+		std::cout << "Could not parse the condition " << breakpoint.condition << std::endl;
+		return false;
+	}
+
+	breakpoints.push_back(breakpoint);
+	if(breakpoints.back().high < breakpoints.back().low)
+	{
+		breakpoints.back().high = breakpoints.back().low;
+	}
+	conditions.push_back(condition);
+	UpdateTypes();
+	return true;
+}
+
+
+void Debugger::Remove(const size_t index)
+{
+	if(index < breakpoints.size())
+	{
+		breakpoints.erase(breakpoints.begin() + index);
+		conditions.erase(conditions.begin() + index);
+		UpdateTypes();
+	}
+}
+
+
+void Debugger::Enable(const size_t index, const bool enabled)
+{
+	if(index < breakpoints.size())
+	{
+		breakpoints[index].enabled = enabled;
+		UpdateTypes();
+	}
+}
+
+
+const std::vector<Breakpoint>& Debugger::Breakpoints() const
+{
+	return breakpoints;
+}
+
+
+const bool Debugger::Stopped() const
+{
+	return stopped;
+}
+
+
+void Debugger::Resume()
+{
+	stopped = false;
+	stepping = false;
+	skipExec = beforeInstruction;
+}
+
+
+void Debugger::Step()
+{
+	stopped = false;
+	stepping = true;
+	skipExec = true;
+}
+
+
+const std::string& Debugger::Reason() const
+{
+	return reason;
+}
+
+
+void Debugger::Exec(const DebugContext &context) //before every instruction
+{
+	if(skipExec)
+	{
+		skipExec = false;
+	}
+	else if(stepping)
+	{
+		stepping = false;
+		stopped = true;
+		beforeInstruction = true;
+		reason = "step";
+	}
+	else if(cpuTypes[context.pc] & BreakExec)
+	{
+		Check(CpuSpace, BreakExec, context);
+	}
+}
+
+
+void Debugger::Access(const DebugSpace space, const uint8_t type, const DebugContext &context) //after a read or write the core asked Wants about
+{
+	Check(space, type, context);
+}
+
+
+void Debugger::Check(const DebugSpace space, const uint8_t type, const DebugContext &context)
+{
+	const uint16_t address = (type == BreakExec) ? context.pc : context.address;
+	for(size_t x = 0; x < breakpoints.size(); ++x)
+	{
+		Breakpoint &breakpoint = breakpoints[x];
+		if(!breakpoint.enabled || breakpoint.space != space || !(breakpoint.type & type) || address < breakpoint.low || address > breakpoint.high)
+		{
+			continue;
+		}
+		if(!conditions[x].empty() && !Evaluate(conditions[x], context))
+		{
+			continue;
+		}
+
+		++breakpoint.hits;
+		stopped = true;
+		stepping = false;
+		beforeInstruction = (type == BreakExec);
+		char text[64];
+		const char *typeName = (type == BreakExec) ? "exec" : (type == BreakRead) ? "read" : "write";
+		std::snprintf(text, sizeof(text), "%s %s $%04X, breakpoint %u", space == CpuSpace ? "cpu" : "ppu", typeName, address, unsigned(x));
+		reason = text;
+	}
+}
+
+
+void Debugger::UpdateTypes()
+{
+	cpuTypes.fill(0);
+	ppuTypes.fill(0);
+	for(const auto &breakpoint : breakpoints)
+	{
+		if(!breakpoint.enabled)
+		{
+			continue;
+		}
+		for(uint32_t address = breakpoint.low; address <= breakpoint.high; ++address)
+		{
+			if(breakpoint.space == CpuSpace)
+			{
+				cpuTypes[address] |= breakpoint.type;
+			}
+			else
+			{
+				ppuTypes[address & 0x3FFF] |= breakpoint.type;
+			}
+		}
+	}
+}
+
+
+//conditions are c expressions over numbers ($hex or decimal) and the fields of DebugContext,
+//compiled to postfix once when the breakpoint is added
+bool Debugger::Compile(const std::string &text, Expression &expression) const
+{
+	expression.clear();
+	size_t pos = 0;
+	if(!ParseBinary(text, pos, 1, expression))
+	{
+		return false;
+	}
+	while(pos < text.size() && std::isspace(text[pos]))
+	{
+		++pos;
+	}
+	return pos == text.size();
+}
+
+
+bool Debugger::ParseBinary(const std::string &text, size_t &pos, const uint8_t precedence, Expression &out) const
+{
+	struct Operator
+	{
+		const char *symbol;
+		Op op;
+		uint8_t precedence;
+	};
+	//two character operators first so they aren't taken for their first half
+	const std::array<Operator, 17> operators
+	{{
+		{"||", OpLogOr, 1}, {"&&", OpLogAnd, 2}, {"==", OpEq, 6}, {"!=", OpNe, 6}, {"<=", OpLe, 7}, {">=", OpGe, 7},
+		{"<<", OpShl, 8}, {">>", OpShr, 8}, {"|", OpOr, 3}, {"^", OpXor, 4}, {"&", OpAnd, 5}, {"<", OpLt, 7},
+		{">", OpGt, 7}, {"+", OpAdd, 9}, {"-", OpSub, 9}, {"*", OpMul, 10}, {"/", OpDiv, 10}
+	}};
+
+	if(!ParseUnary(text, pos, out))
+	{
+		return false;
+	}
+
+	while(true)
+	{
+		while(pos < text.size() && std::isspace(text[pos]))
+		{
+			++pos;
+		}
+
+		const Operator *found = nullptr;
+		for(const auto &o : operators)
+		{
+			if(text.compare(pos, std::strlen(o.symbol), o.symbol) == 0)
+			{
+				found = &o;
+				break;
+			}
+		}
+		if(!found || found->precedence < precedence)
+		{
+			return true;
+		}
+
+		pos += std::strlen(found->symbol);
+		if(!ParseBinary(text, pos, found->precedence + 1, out)) //left to right
+		{
+			return false;
+		}
+		out.push_back({found->op, 0});
+	}
+}
+
+
+bool Debugger::ParseUnary(const std::string &text, size_t &pos, Expression &out) const
+{
+	const std::array<const char*, 11> fields{{"pc", "addr", "a", "x", "y", "s", "p", "value", "scanline", "dot", "cycle"}};
+
+	while(pos < text.size() && std::isspace(text[pos]))
+	{
+		++pos;
+	}
+	if(pos == text.size())
+	{
+		return false;
+	}
+
+	const char c = text[pos];
+	if(c == '(')
+	{
+		++pos;
+		if(!ParseBinary(text, pos, 1, out))
+		{
+			return false;
+		}
+		while(pos < text.size() && std::isspace(text[pos]))
+		{
+			++pos;
+		}
+		if(pos == text.size() || text[pos] != ')')
+		{
+			return false;
+		}
+		++pos;
+		return true;
+	}
+	else if(c == '-' || c == '!' || c == '~')
+	{
+		++pos;
+		if(!ParseUnary(text, pos, out))
+		{
+			return false;
+		}
+		out.push_back({c == '-' ? OpNeg : c == '!' ? OpNot : OpBitNot, 0});
+		return true;
+	}
+	else if(c == '$' || std::isdigit(c))
+	{
+		const bool hex = (c == '$');
+		pos += hex;
+		const size_t start = pos;
+		while(pos < text.size() && (hex ? std::isxdigit(text[pos]) : std::isdigit(text[pos])))
+		{
+			++pos;
+		}
+		if(pos == start || pos - start > 8)
+		{
+			return false;
+		}
+		out.push_back({OpPush, uint32_t(std::stoul(text.substr(start, pos - start), nullptr, hex ? 16 : 10))});
+		return true;
+	}
+	else if(std::isalpha(c))
+	{
+		const size_t start = pos;
+		while(pos < text.size() && std::isalpha(text[pos]))
+		{
+			++pos;
+		}
+		std::string name = text.substr(start, pos - start);
+		for(auto &letter : name)
+		{
+			letter = std::tolower(letter);
+		}
+		for(uint32_t x = 0; x < fields.size(); ++x)
+		{
+			if(name == fields[x])
+			{
+				out.push_back({OpVar, x});
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+const int64_t Debugger::Evaluate(const Expression &expression, const DebugContext &context) const
+{
+	const std::array<int64_t, 11> fields
+	{{
+		context.pc, context.address, context.a, context.x, context.y, context.s, context.p,
+		context.value, context.scanline, context.dot, context.cycle
+	}};
+
+	std::vector<int64_t> stack;
+	for(const auto &token : expression)
+	{
+		if(token.op == OpPush || token.op == OpVar)
+		{
+			stack.push_back(token.op == OpPush ? token.value : fields[token.value]);
+			continue;
+		}
+		if(token.op <= OpBitNot)
+		{
+			int64_t &v = stack.back();
+			v = (token.op == OpNeg) ? -v : (token.op == OpNot) ? !v : ~v;
+			continue;
+		}
+
+		const int64_t r = stack.back();
+		stack.pop_back();
+		int64_t &l = stack.back();
+		switch(token.op)
+		{
+			case OpMul:    l = l * r;                break;
+			case OpDiv:    l = r ? l / r : 0;        break;
+			case OpAdd:    l = l + r;                break;
+			case OpSub:    l = l - r;                break;
+			case OpShl:    l = l << (r & 63);        break;
+			case OpShr:    l = l >> (r & 63);        break;
+			case OpLt:     l = l < r;                break;
+			case OpLe:     l = l <= r;               break;
+			case OpGt:     l = l > r;                break;
+			case OpGe:     l = l >= r;               break;
+			case OpEq:     l = l == r;               break;
+			case OpNe:     l = l != r;               break;
+			case OpAnd:    l = l & r;                break;
+			case OpXor:    l = l ^ r;                break;
+			case OpOr:     l = l | r;                break;
+			case OpLogAnd: l = l && r;               break;
+			case OpLogOr:  l = l || r;               break;
+			default: break;
+		}
+	}
+	return stack.empty() ? 0 : stack.back();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+enum BreakType : uint8_t {BreakExec = 1, BreakRead = 2, BreakWrite = 4};
+enum DebugSpace : uint8_t {CpuSpace = 0, PpuSpace = 1}; //ppu accesses are the cpu's through $2007
+
+//what a condition can look at, the cpu as it is in the middle of the access
+struct DebugContext
+{
+	uint16_t pc, address;
+	uint8_t a, x, y, s, p, value;
+	uint16_t scanline, dot;
+	uint32_t cycle;
+};
+
+struct Breakpoint
+{
+	uint16_t low = 0, high = 0;
+	uint8_t type = BreakExec;
+	DebugSpace space = CpuSpace;
+	std::string condition; //empty always breaks, e.g. "a == $10 && scanline > 200"
+	bool enabled = true;
+	uint32_t hits = 0;
+};
+
+//breakpoints for the cpu core's debug variant. the core only runs that variant while a debugger is
+//attached, without one there isn't a single check. a hit stops the frame at the next instruction boundary
+class Debugger
+{
+	public:
+		bool Add(const Breakpoint &breakpoint); //false if the condition doesn't parse
+		void Remove(const size_t index);
+		void Enable(const size_t index, const bool enabled);
+		const std::vector<Breakpoint>& Breakpoints() const;
+
+		const bool Stopped() const;
+		void Resume();
+		void Step(); //runs the next instruction and stops in front of the one after
+		const std::string& Reason() const;
+
+		const bool Wants(const DebugSpace space, const uint16_t address, const uint8_t type) const
+		{
+			return (space == CpuSpace ? cpuTypes[address] : ppuTypes[address & 0x3FFF]) & type;
+		}
+		void Exec(const DebugContext &context);
+		void Access(const DebugSpace space, const uint8_t type, const DebugContext &context);
+
+	private:
+		enum Op : uint8_t {OpPush, OpVar, OpNeg, OpNot, OpBitNot, OpMul, OpDiv, OpAdd, OpSub, OpShl, OpShr, OpLt, OpLe, OpGt, OpGe, OpEq, OpNe, OpAnd, OpXor, OpOr, OpLogAnd, OpLogOr};
+		struct Token
+		{
+			Op op;
+			uint32_t value; //the number for OpPush, the field for OpVar
+		};
+		typedef std::vector<Token> Expression; //postfix
+
+		bool Compile(const std::string &text, Expression &expression) const;
+		bool ParseBinary(const std::string &text, size_t &pos, const uint8_t precedence, Expression &out) const;
+		bool ParseUnary(const std::string &text, size_t &pos, Expression &out) const;
+		const int64_t Evaluate(const Expression &expression, const DebugContext &context) const;
+		void Check(const DebugSpace space, const uint8_t type, const DebugContext &context);
+		void UpdateTypes();
+
+		std::vector<Breakpoint> breakpoints;
+		std::vector<Expression> conditions;
+		std::array<uint8_t, 0x10000> cpuTypes{}; //every type some enabled breakpoint has at each address
+		std::array<uint8_t, 0x4000> ppuTypes{};
+
+		bool stopped = false;
+		bool beforeInstruction = false; //exec stops are in front of the instruction, accesses stop after it
+		bool skipExec = false;          //so it runs on resume instead of breaking again
+		bool stepping = false;
+		std::string reason;
+};
@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "eventlog.hpp"
+
+
+const std::array<uint32_t, 5> EventLog::colors{{0xFF40FF40, 0xFFFFFF40, 0xFFFF40FF, 0xFF40C0FF, 0xFF4040FF}}; //green, cyan, magenta, orange, red
+
+
+EventLog::EventLog(const size_t capacity)
+{
+	recording.resize(capacity);
+	frame.reserve(capacity);
+}
+
+
+void EventLog::EndFrame()
+{
+	frame.assign(recording.begin(), recording.begin() + count); //no allocation, the capacity is already there
+	frameDropped = dropped;
+	count = 0;
+	dropped = 0;
+}
+
+
+const std::vector<PpuEvent>& EventLog::Events() const
+{
+	return frame;
+}
+
+
+const uint32_t EventLog::Dropped() const
+{
+	return frameDropped;
+}
+
+
+void EventLog::Draw(uint32_t *pixels, const uint16_t width, const uint8_t scale) const
+{
+	for(const auto &event : frame)
+	{
+		if(event.scanline >= 240)
+		{
+			continue;
+		}
+
+		const uint16_t x = (event.dot >= 1 && event.dot <= 256) ? event.dot - 1 : 255;
+		uint32_t *mark = pixels + event.scanline * scale * width + x * scale;
+		for(uint8_t row = 0; row < scale; ++row)
+		{
+			std::fill(mark + row * width, mark + row * width + scale, colors[event.type]);
+		}
+	}
+}
+
+
+const char* EventLog::Name(const PpuEventType type)
+{
+	switch(type)
+	{
+		case EventRegisterWrite: return "write";
+		case EventStatusRead:    return "$2002";
+		case EventOamDma:        return "dma";
+		case EventMapperWrite:   return "mapper";
+		case EventIrq:           return "irq";
+		default:                 return "";
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+enum PpuEventType : uint8_t {EventRegisterWrite, EventStatusRead, EventOamDma, EventMapperWrite, EventIrq};
+
+struct PpuEvent
+{
+	uint16_t scanline, dot;
+	uint16_t address;
+	uint8_t value;
+	PpuEventType type;
+};
+
+//what the cpu did to the ppu and mappers during a frame and where the beam was, for raster effects.
+//events go into a buffer allocated up front, a full buffer drops the rest of the frame
+class EventLog
+{
+	public:
+		EventLog(const size_t capacity = 1 << 14);
+
+		void Record(const PpuEvent &event)
+		{
+			if(count < recording.size())
+			{
+				recording[count++] = event;
+			}
+			else
+			{
+				++dropped;
+			}
+		}
+		void EndFrame(); //what was recorded becomes the frame that's shown
+
+		const std::vector<PpuEvent>& Events() const; //the last complete frame
+		const uint32_t Dropped() const;
+		void Draw(uint32_t *pixels, const uint16_t width, const uint8_t scale) const; //marks on a frame scaled up by scale, events in hblank at its right edge
+
+		static const std::array<uint32_t, 5> colors; //by PpuEventType, 0xAABBGGRR like the frame
+		static const char* Name(const PpuEventType type);
+
+	private:
+		std::vector<PpuEvent> recording, frame;
+		size_t count = 0;
+		uint32_t dropped = 0, frameDropped = 0;
+};
@@ -0,0 +1,527 @@
+#include <cmath>
+
+#include "expansion.hpp"
+
+
+ExpansionAudio::ExpansionAudio()
+{
+	ClearPadding(vrc6Pulse);
+	ClearPadding(vrc6Saw);
+	ClearPadding(mmc5Pulse);
+	ClearPadding(tone);
+	ClearPadding(envelope);
+
+	//sunsoft 5b volume is logarithmic, 1.5db per envelope step (3db per register step)
+	sunsoftLevel[0] = 0;
+	for(uint8_t x = 1; x < 32; ++x)
+	{
+		sunsoftLevel[x] = std::pow(10.0, (x - 31) * 1.5 / 20.0) * 0.15;
+	}
+}
+
+
+void ExpansionAudio::SetChip(const ExpansionChip newChip)
+{
+	chip = newChip;
+}
+
+
+void ExpansionAudio::Vrc6Write(const uint16_t address, const uint8_t dataBus)
+{
+	switch(address)
+	{
+		case 0x9000: case 0xA000:
+		{
+			Vrc6Pulse &p = vrc6Pulse[(address >> 12) - 9];
+			p.ignoreDuty = dataBus & 0x80;
+			p.duty = (dataBus >> 4) & 0b0111;
+			p.volume = dataBus & 0x0F;
+		}
+		break;
+
+		case 0x9001: case 0xA001:
+		{
+			Vrc6Pulse &p = vrc6Pulse[(address >> 12) - 9];
+			p.freqTimer = (p.freqTimer & 0x0F00) | dataBus;
+		}
+		break;
+
+		case 0x9002: case 0xA002:
+		{
+			Vrc6Pulse &p = vrc6Pulse[(address >> 12) - 9];
+			p.freqTimer = (p.freqTimer & 0xFF) | ((dataBus & 0x0F) << 8);
+			p.enable = dataBus & 0x80;
+			if(!p.enable)
+			{
+				p.dutyCounter = 15;
+			}
+		}
+		break;
+
+		case 0x9003:
+			vrc6Halt = dataBus & 1;
+			vrc6Shift = (dataBus & 0b0100) ? 8 : (dataBus & 0b0010) ? 4 : 0;
+		break;
+
+		case 0xB000:
+			vrc6Saw.rate = dataBus & 0b00111111;
+		break;
+
+		case 0xB001:
+			vrc6Saw.freqTimer = (vrc6Saw.freqTimer & 0x0F00) | dataBus;
+		break;
+
+		case 0xB002:
+			vrc6Saw.freqTimer = (vrc6Saw.freqTimer & 0xFF) | ((dataBus & 0x0F) << 8);
+			vrc6Saw.enable = dataBus & 0x80;
+			if(!vrc6Saw.enable)
+			{
+				vrc6Saw.accumulator = 0;
+				vrc6Saw.step = 0;
+			}
+		break;
+	}
+}
+
+
+void ExpansionAudio::Mmc5Write(const uint16_t address, const uint8_t dataBus)
+{
+	const std::array<uint8_t, 4> dutyTable{{0b00000010, 0b00000110, 0b00011110, 0b11111001}};
+	Mmc5Pulse &p = mmc5Pulse[(address >> 2) & 1];
+
+	switch(address)
+	{
+		case 0x5000: case 0x5004:
+			p.duty = dutyTable[dataBus >> 6];
+			p.halt = dataBus & 0b00100000;
+			p.constant = dataBus & 0b00010000;
+			p.volume = dataBus & 0b00001111;
+		break;
+
+		case 0x5002: case 0x5006:
+			p.freqTimer = (p.freqTimer & 0x700) | dataBus;
+		break;
+
+		case 0x5003: case 0x5007:
+			p.freqTimer = (p.freqTimer & 0xFF) | ((dataBus & 0b00000111) << 8);
+			if(p.enable)
+			{
+				p.lengthCounter = lengthTable[dataBus >> 3];
+			}
+			p.dutyCounter = 1;
+			p.envelopeReset = true;
+		break;
+
+		case 0x5011: //pcm write mode, 0 is ignored
+			if(dataBus)
+			{
+				mmc5Pcm = dataBus;
+			}
+		break;
+
+		case 0x5015:
+			for(uint8_t x = 0; x < 2; ++x)
+			{
+				mmc5Pulse[x].enable = dataBus & (1 << x);
+				if(!mmc5Pulse[x].enable)
+				{
+					mmc5Pulse[x].lengthCounter = 0;
+				}
+			}
+		break;
+	}
+}
+
+
+const uint8_t ExpansionAudio::Mmc5StatusRead() const
+{
+	return (mmc5Pulse[0].lengthCounter ? 1 : 0) | (mmc5Pulse[1].lengthCounter ? 2 : 0);
+}
+
+
+void ExpansionAudio::Sunsoft5BSelect(const uint8_t dataBus)
+{
+	sunsoftRegister = dataBus & 0x0F;
+}
+
+
+void ExpansionAudio::Sunsoft5BWrite(const uint8_t dataBus)
+{
+	switch(sunsoftRegister)
+	{
+		case 0x0: case 0x2: case 0x4:
+			tone[sunsoftRegister >> 1].freqTimer = (tone[sunsoftRegister >> 1].freqTimer & 0x0F00) | dataBus;
+		break;
+
+		case 0x1: case 0x3: case 0x5:
+			tone[sunsoftRegister >> 1].freqTimer = (tone[sunsoftRegister >> 1].freqTimer & 0xFF) | ((dataBus & 0x0F) << 8);
+		break;
+
+		case 0x6:
+			noisePeriod = dataBus & 0b00011111;
+		break;
+
+		case 0x7:
+			for(uint8_t x = 0; x < 3; ++x)
+			{
+				tone[x].toneDisable = (dataBus >> x) & 1;
+				tone[x].noiseDisable = (dataBus >> (x + 3)) & 1;
+			}
+		break;
+
+		case 0x8: case 0x9: case 0xA:
+			tone[sunsoftRegister - 8].volume = dataBus & 0x0F;
+			tone[sunsoftRegister - 8].envelope = dataBus & 0x10;
+		break;
+
+		case 0xB:
+			envelope.freqTimer = (envelope.freqTimer & 0xFF00) | dataBus;
+		break;
+
+		case 0xC:
+			envelope.freqTimer = (envelope.freqTimer & 0xFF) | (dataBus << 8);
+		break;
+
+		case 0xD:
+			envelope.shape = dataBus & 0x0F;
+			envelope.attack = dataBus & 0b0100;
+			envelope.level = envelope.attack ? 0 : 31;
+			envelope.step = 0;
+			envelope.freqCounter = 0;
+			envelope.holding = false;
+		break;
+	}
+}
+
+
+void ExpansionAudio::N163AddressWrite(const uint8_t dataBus)
+{
+	n163Address = dataBus & 0x7F;
+	n163AutoIncrement = dataBus & 0x80;
+}
+
+
+const uint8_t ExpansionAudio::N163DataRead()
+{
+	const uint8_t data = n163Ram[n163Address];
+	if(n163AutoIncrement)
+	{
+		++n163Address &= 0x7F;
+	}
+	return data;
+}
+
+
+void ExpansionAudio::N163DataWrite(const uint8_t dataBus)
+{
+	n163Ram[n163Address] = dataBus;
+	if(n163AutoIncrement)
+	{
+		++n163Address &= 0x7F;
+	}
+}
+
+
+void ExpansionAudio::N163Enable(const bool enable)
+{
+	n163Enable = enable;
+}
+
+
+void ExpansionAudio::Tick()
+{
+	switch(chip)
+	{
+		case Vrc6Chip:      Vrc6Tick();      break;
+		case Mmc5Chip:      Mmc5Tick();      break;
+		case Sunsoft5BChip: Sunsoft5BTick(); break;
+		case N163Chip:      N163Tick();      break;
+		case NoChip:                         break;
+	}
+}
+
+
+void ExpansionAudio::Vrc6Tick()
+{
+	if(vrc6Halt)
+	{
+		return;
+	}
+
+	for(auto &p : vrc6Pulse)
+	{
+		if(p.enable)
+		{
+			if(p.freqCounter == 0)
+			{
+				p.freqCounter = p.freqTimer >> vrc6Shift;
+				--p.dutyCounter &= 0x0F;
+			}
+			else
+			{
+				--p.freqCounter;
+			}
+		}
+	}
+
+	if(vrc6Saw.enable)
+	{
+		if(vrc6Saw.freqCounter == 0)
+		{
+			vrc6Saw.freqCounter = vrc6Saw.freqTimer >> vrc6Shift;
+			if(++vrc6Saw.step == 14) //6 additions on even steps, then restart
+			{
+				vrc6Saw.step = 0;
+				vrc6Saw.accumulator = 0;
+			}
+			else if(!(vrc6Saw.step & 1))
+			{
+				vrc6Saw.accumulator += vrc6Saw.rate;
+			}
+		}
+		else
+		{
+			--vrc6Saw.freqCounter;
+		}
+	}
+}
+
+
+void ExpansionAudio::Mmc5Tick()
+{
+	if(mmc5Tick)
+	{
+		for(auto &p : mmc5Pulse)
+		{
+			if(p.freqCounter-- == 0)
+			{
+				p.freqCounter = p.freqTimer;
+				p.dutyCounter <<= 1;
+				if(!p.dutyCounter)
+				{
+					p.dutyCounter = 1;
+				}
+			}
+		}
+	}
+	mmc5Tick = !mmc5Tick;
+
+	if(++mmc5FrameCounter == 7457) //envelopes and length counters run at a fixed 240hz
+	{
+		mmc5FrameCounter = 0;
+		Mmc5Frame();
+	}
+}
+
+
+void ExpansionAudio::Mmc5Frame()
+{
+	for(auto &p : mmc5Pulse)
+	{
+		if(p.envelopeReset)
+		{
+			p.envelopeReset = false;
+			p.envelopeVolume = 15;
+			p.envelopeCounter = p.volume;
+		}
+		else if(!p.envelopeCounter--)
+		{
+			p.envelopeCounter = p.volume;
+			if(p.envelopeVolume)
+			{
+				--p.envelopeVolume;
+			}
+			else if(p.halt)
+			{
+				p.envelopeVolume = 15;
+			}
+		}
+
+		if(!p.halt && p.lengthCounter)
+		{
+			--p.lengthCounter;
+		}
+	}
+}
+
+
+void ExpansionAudio::Sunsoft5BTick()
+{
+	if(++sunsoftDivider < 16)
+	{
+		return;
+	}
+	sunsoftDivider = 0;
+
+	for(auto &t : tone)
+	{
+		if(++t.freqCounter >= t.freqTimer)
+		{
+			t.freqCounter = 0;
+			t.output = !t.output;
+		}
+	}
+
+	if(++noiseCounter >= (noisePeriod << 1))
+	{
+		noiseCounter = 0;
+		const uint32_t feedback = (noiseLfsr ^ (noiseLfsr >> 3)) & 1;
+		noiseLfsr = (noiseLfsr >> 1) | (feedback << 16);
+	}
+
+	if(!envelope.holding && ++envelope.freqCounter >= envelope.freqTimer)
+	{
+		envelope.freqCounter = 0;
+		if(++envelope.step < 32)
+		{
+			envelope.level = envelope.attack ? envelope.step : 31 - envelope.step;
+		}
+		else if(!(envelope.shape & 0b1000)) //no continue: drop to 0
+		{
+			envelope.holding = true;
+			envelope.level = 0;
+		}
+		else if(envelope.shape & 0b0001) //hold, alternate holds the opposite end
+		{
+			envelope.holding = true;
+			envelope.level = (envelope.attack != bool(envelope.shape & 0b0010)) ? 31 : 0;
+		}
+		else
+		{
+			if(envelope.shape & 0b0010)
+			{
+				envelope.attack = !envelope.attack;
+			}
+			envelope.step = 0;
+			envelope.level = envelope.attack ? 0 : 31;
+		}
+	}
+}
+
+
+void ExpansionAudio::N163Tick()
+{
+	if(++n163Divider < 15) //one channel is updated every 15 cycles
+	{
+		return;
+	}
+	n163Divider = 0;
+
+	if(!n163Enable)
+	{
+		return;
+	}
+
+	const uint8_t channels = ((n163Ram[0x7F] >> 4) & 0b0111) + 1;
+	const uint8_t base = 0x40 + n163Channel * 8;
+
+	const uint32_t freq = n163Ram[base] | (n163Ram[base + 2] << 8) | ((n163Ram[base + 4] & 0b11) << 16);
+	const uint32_t length = (256 - (n163Ram[base + 4] & 0xFC)) << 16;
+	uint32_t phase = n163Ram[base + 1] | (n163Ram[base + 3] << 8) | (n163Ram[base + 5] << 16);
+
+	phase = (phase + freq) % length;
+	n163Ram[base + 1] = phase;
+	n163Ram[base + 3] = phase >> 8;
+	n163Ram[base + 5] = phase >> 16;
+
+	const uint8_t sampleAddress = (phase >> 16) + n163Ram[base + 6];
+	const uint8_t sample = (n163Ram[sampleAddress >> 1] >> ((sampleAddress & 1) << 2)) & 0x0F;
+	n163Output[n163Channel] = (sample - 8) * (n163Ram[base + 7] & 0x0F);
+
+	n163Channel = (n163Channel == 8 - channels) ? 7 : n163Channel - 1;
+}
+
+
+const float ExpansionAudio::Output() const
+{
+	float output = 0;
+
+	switch(chip)
+	{
+		case Vrc6Chip:
+		{
+			uint8_t level = vrc6Saw.enable ? vrc6Saw.accumulator >> 3 : 0;
+			for(const auto &p : vrc6Pulse)
+			{
+				if(p.enable && (p.ignoreDuty || p.dutyCounter <= p.duty))
+				{
+					level += p.volume;
+				}
+			}
+			output = level * 0.0095f; //roughly the level of an apu pulse step
+		}
+		break;
+
+		case Mmc5Chip:
+		{
+			uint8_t level = 0;
+			for(const auto &p : mmc5Pulse)
+			{
+				if(p.duty & p.dutyCounter && p.lengthCounter)
+				{
+					level += (p.constant) ? p.volume : p.envelopeVolume;
+				}
+			}
+			output = level * 0.0095f + mmc5Pcm * 0.002f;
+		}
+		break;
+
+		case Sunsoft5BChip:
+			for(const auto &t : tone)
+			{
+				if((t.output | t.toneDisable) && ((noiseLfsr & 1) | t.noiseDisable))
+				{
+					output += sunsoftLevel[t.envelope ? envelope.level : (t.volume ? t.volume * 2 + 1 : 0)];
+				}
+			}
+		break;
+
+		case N163Chip:
+			if(n163Enable) //channels are time multiplexed, so more channels means each one is quieter
+			{
+				const uint8_t channels = ((n163Ram[0x7F] >> 4) & 0b0111) + 1;
+				int16_t level = 0;
+				for(uint8_t x = 8 - channels; x < 8; ++x)
+				{
+					level += n163Output[x];
+				}
+				output = level * 0.002f / channels;
+			}
+		break;
+
+		case NoChip:
+		break;
+	}
+
+	return output;
+}
+
+
+void ExpansionAudio::Serialize(State &state)
+{
+	state.Data(vrc6Pulse);
+	state.Data(vrc6Saw);
+	state.Data(vrc6Shift);
+	state.Data(vrc6Halt);
+
+	state.Data(mmc5Pulse);
+	state.Data(mmc5Pcm);
+	state.Data(mmc5FrameCounter);
+	state.Data(mmc5Tick);
+
+	state.Data(tone);
+	state.Data(envelope);
+	state.Data(noiseLfsr);
+	state.Data(noisePeriod);
+	state.Data(noiseCounter);
+	state.Data(sunsoftRegister);
+	state.Data(sunsoftDivider);
+
+	state.Data(n163Ram);
+	state.Data(n163Output);
+	state.Data(n163Address);
+	state.Data(n163Channel);
+	state.Data(n163Divider);
+	state.Data(n163AutoIncrement);
+	state.Data(n163Enable);
+}
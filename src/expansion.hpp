@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+#include "state.hpp"
+
+
+enum ExpansionChip : uint8_t {NoChip = 0, Vrc6Chip = 1, Mmc5Chip = 2, Sunsoft5BChip = 3, N163Chip = 4};
+
+struct Vrc6Pulse
+{
+	uint16_t freqTimer, freqCounter;
+	uint8_t duty, dutyCounter, volume;
+	bool enable, ignoreDuty;
+};
+
+struct Vrc6Saw
+{
+	uint16_t freqTimer, freqCounter;
+	uint8_t rate, accumulator, step;
+	bool enable;
+};
+
+struct Mmc5Pulse
+{
+	uint16_t freqTimer, freqCounter;
+	uint8_t duty, dutyCounter;
+	uint8_t volume, envelopeVolume;
+	uint8_t envelopeCounter, lengthCounter;
+	bool enable, halt, constant, envelopeReset;
+};
+
+struct Sunsoft5BTone
+{
+	uint16_t freqTimer, freqCounter;
+	uint8_t volume;
+	bool output, toneDisable, noiseDisable, envelope;
+};
+
+struct Sunsoft5BEnvelope
+{
+	uint16_t freqTimer, freqCounter;
+	uint8_t shape, step, level;
+	bool holding, attack;
+};
+
+
+class ExpansionAudio
+{
+	public:
+		ExpansionAudio();
+
+		void SetChip(const ExpansionChip newChip);
+
+		void Vrc6Write(const uint16_t address, const uint8_t dataBus); //9000-9003, A000-A002, B000-B002
+
+		void Mmc5Write(const uint16_t address, const uint8_t dataBus); //5000-5015
+		const uint8_t Mmc5StatusRead() const;                          //5015
+
+		void Sunsoft5BSelect(const uint8_t dataBus);                   //C000
+		void Sunsoft5BWrite(const uint8_t dataBus);                    //E000
+
+		void N163AddressWrite(const uint8_t dataBus);                  //F800
+		const uint8_t N163DataRead();                                  //4800
+		void N163DataWrite(const uint8_t dataBus);                     //4800
+		void N163Enable(const bool enable);                            //E000 bit 6
+
+		void Tick();
+		const float Output() const;
+
+		void Serialize(State &state);
+
+		ExpansionChip chip = NoChip;
+
+	private:
+		void Vrc6Tick();
+		void Mmc5Tick();
+		void Mmc5Frame();
+		void Sunsoft5BTick();
+		void N163Tick();
+
+		//vrc6
+		std::array<Vrc6Pulse, 2> vrc6Pulse{};
+		Vrc6Saw vrc6Saw{};
+		uint8_t vrc6Shift = 0;
+		bool vrc6Halt = false;
+
+		//mmc5
+		std::array<Mmc5Pulse, 2> mmc5Pulse{};
+		uint8_t mmc5Pcm = 0;
+		uint16_t mmc5FrameCounter = 0;
+		bool mmc5Tick = true;
+
+		//sunsoft 5b
+		std::array<Sunsoft5BTone, 3> tone{};
+		Sunsoft5BEnvelope envelope{};
+		uint32_t noiseLfsr = 1;
+		uint8_t noisePeriod = 0, noiseCounter = 0;
+		uint8_t sunsoftRegister = 0;
+		uint8_t sunsoftDivider = 0;
+		std::array<float, 32> sunsoftLevel;
+
+		//namco 163
+		std::array<uint8_t, 0x80> n163Ram{};
+		std::array<int8_t, 8> n163Output{};
+		uint8_t n163Address = 0;
+		uint8_t n163Channel = 7;
+		uint8_t n163Divider = 0;
+		bool n163AutoIncrement = false;
+		bool n163Enable = true;
+
+		const std::array<uint8_t, 32> lengthTable
+		{{
+			10,254, 20,  2, 40,  4, 80,  6,160,  8, 60, 10, 14, 12, 26, 14,
+			12, 16, 24, 18, 48, 20, 96, 22,192, 24, 72, 26, 16, 28, 32, 30
+		}};
+};
@@ -11,8 +11,8 @@ const std::vector<uint8_t> FileToU8Vec(const std::string inFile)
 	std::ifstream iFile(inFile.c_str(), std::ios::in | std::ios::binary);
 	if(iFile.is_open() == false)
 	{
-		std::cout << "File not found" << std::endl;
-		exit(0);
+		std::cout << inFile << " not found" << std::endl;
+		return {};
 	}
 
 	std::ostringstream contents;
@@ -1,4 +1,4 @@
 #pragma once
 
 
-const std::vector<uint8_t> FileToU8Vec(const std::string inFile);
+const std::vector<uint8_t> FileToU8Vec(const std::string inFile); //empty if it can't be read
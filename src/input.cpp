@@ -0,0 +1,122 @@
+#include "input.hpp"
+
+
+void InputPorts::Connect(const uint8_t port, const InputDevice device)
+{
+	devices[port] = device;
+	Reload(port);
+}
+
+
+const InputDevice InputPorts::Device(const uint8_t port) const
+{
+	return devices[port];
+}
+
+
+void InputPorts::SetFrame(const InputFrame &input, const bool pollFrame)
+{
+	frame = input;
+	pollPending = pollFrame && poll;
+	if(strobe)
+	{
+		Reload(0);
+		Reload(1);
+	}
+}
+
+
+void InputPorts::SetPoll(std::function<void(InputFrame&)> newPoll)
+{
+	poll = newPoll;
+}
+
+
+const InputFrame& InputPorts::Frame() const
+{
+	return frame;
+}
+
+
+void InputPorts::Poll()
+{
+	//games latch once a frame, usually in the nmi at the end of it. asking the frontend here instead of
+	//before the frame runs takes most of a frame of input lag away
+	pollPending = false;
+	poll(frame);
+}
+
+
+const uint8_t InputPorts::Read(const uint8_t port, const uint32_t cycle, const Ppu &ppu)
+{
+	//the port is clocked when the read ends, reads on back to back cycles like a dmc dma halt are one long read
+	const bool clock = cycle != lastRead[port] + 1;
+	lastRead[port] = cycle;
+
+	switch(devices[port])
+	{
+		case DevicePad: case DeviceFourScore:
+		{
+			if(strobe)
+			{
+				Reload(port);
+			}
+			const uint8_t data = shift[port] & 1;
+			if(clock)
+			{
+				shift[port] = (shift[port] >> 1) | 0x80000000;
+			}
+			return data;
+		}
+
+		case DeviceZapper:
+			return frame.trigger << 4 | !ppu.SensesLight(frame.pointerX, frame.pointerY) << 3; //0 is light
+
+		case DeviceArkanoid:
+		{
+			if(strobe)
+			{
+				Reload(port);
+			}
+			const uint8_t data = ((shift[port] >> 7) & 1) << 4 | frame.trigger << 3; //the knob goes out msb first
+			if(clock)
+			{
+				shift[port] <<= 1;
+			}
+			return data;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+
+void InputPorts::Reload(const uint8_t port)
+{
+	switch(devices[port])
+	{
+		case DevicePad:
+			shift[port] = 0xFFFFFF00 | frame.pads[port]; //official pads return 1s after the 8 buttons
+		break;
+
+		case DeviceFourScore: //pad 1 or 2, pad 3 or 4, then the signature that tells it apart from a pad
+			shift[port] = 0xFF000000 | (port ? 0x00040000 : 0x00080000) | frame.pads[port + 2] << 8 | frame.pads[port];
+		break;
+
+		case DeviceArkanoid:
+			shift[port] = uint8_t(~frame.paddle);
+		break;
+
+		default:
+		break;
+	}
+}
+
+
+void InputPorts::Serialize(State &state)
+{
+	state.Data(shift);
+	state.Data(lastRead);
+	state.Data(strobe);
+}
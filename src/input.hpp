@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include "ppu.hpp"
+#include "state.hpp"
+
+
+enum InputDevice : uint8_t {DeviceNone, DevicePad, DeviceFourScore, DeviceZapper, DeviceArkanoid};
+
+//everything the devices in both ports see during a frame
+struct InputFrame
+{
+	std::array<uint8_t, 4> pads{}; //bit 0 A, B, select, start, up, down, left, right. 3 and 4 only through a four score
+	int16_t pointerX = -1, pointerY = -1; //zapper aim in frame pixels, off screen outside 256x240
+	bool trigger = false; //zapper trigger or arkanoid button
+	uint8_t paddle = 0x80; //arkanoid knob, the real one reads about $62-$F2
+};
+
+//the two controller ports. the devices are the console's configuration like the mapper, only the shift registers are state
+class InputPorts
+{
+	public:
+		void Connect(const uint8_t port, const InputDevice device);
+		const InputDevice Device(const uint8_t port) const;
+		void SetFrame(const InputFrame &input, const bool pollFrame); //pollFrame lets the poll function update it at the first strobe
+		void SetPoll(std::function<void(InputFrame&)> poll);
+		const InputFrame& Frame() const;
+
+		void Strobe(const uint8_t data)  //$4016 write, the pads follow the buttons while it's high
+		{
+			const bool high = data & 1;
+			if(high && pollPending)
+			{
+				Poll();
+			}
+			if(high || strobe)
+			{
+				Reload(0);
+				Reload(1);
+			}
+			strobe = high;
+		}
+		const uint8_t Read(const uint8_t port, const uint32_t cycle, const Ppu &ppu); //bits 0-4 of $4016/$4017
+
+		void Serialize(State &state);
+
+	private:
+		void Reload(const uint8_t port);
+		void Poll();
+
+		std::array<InputDevice, 2> devices{{DevicePad, DevicePad}};
+		InputFrame frame;
+		std::function<void(InputFrame&)> poll;
+		bool pollPending = false;
+		std::array<uint32_t, 2> shift{};
+		std::array<uint32_t, 2> lastRead{}; //cycle of the last read
+		bool strobe = false;
+};
@@ -8,13 +8,19 @@
 // #include <charconv>
 #endif
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "main.hpp"
+#include "video.hpp"
 
 #ifdef WINDOWS
 	#include "wasapi.hpp"
@@ -25,12 +31,23 @@
 
 int main(int argc, char* argv[])
 {
-	if(argc < 2)
+	if(argc < 2 || (argc > 2 && argc != 4))
 	{
-		std::cout << "nes rom.nes" << std::endl;
+		std::cout << "nes rom.nes [-r movie | -p movie | -v movie]" << std::endl;
+		std::cout << "  -r record a movie from power on" << std::endl;
+		std::cout << "  -p play a movie, then continue with keyboard input" << std::endl;
+		std::cout << "  -v verify a movie without video or audio, as fast as possible" << std::endl;
+		std::cout << "key and gamepad bindings are read from controls.txt if it's there" << std::endl;
 		exit(0);
 	}
 	const std::string infile = argv[1];
+	const std::string movieOption = (argc == 4) ? argv[2] : "";
+	const std::string movieFile = (argc == 4) ? argv[3] : "";
+
+	if(movieOption == "-v")
+	{
+		exit(VerifyMovie(infile, movieFile));
+	}
 
 	// init video
 	if(!glfwInit())
@@ -54,10 +71,52 @@ int main(int argc, char* argv[])
 		exit(1);
 	}
 
-	Nes nes(infile);
+	Nes nes(infile, movieOption.empty() ? BatteryFile : BatteryCopy); //movies run on a copy of the .sav, it has to be the same for recording and playback
+	if(!nes.Loaded())
+	{
+		glfwTerminate();
+		exit(1);
+	}
+	nes.ppu.SetPixelFormat(Indexed); //a byte per pixel, expanded once per shown frame. emphasis is taken per line
+
+	Rewind rewind;
+	Trace trace;
+	bool tracing = false;
+	CodeLogger codeLogger;
+	bool codeLogging = false;
+	Profiler profiler;
+	bool profiling = false;
+	bool jamReported = false;
+	Movie movie;
+	PpuSnapshot ppuSnapshot;
+	PpuViewer ppuViewer;
+	Debugger debugger;
+	EventLog eventLog;
+	if((movieOption == "-r" && !movie.Record(movieFile, nes, PowerOn)) || (movieOption == "-p" && !movie.Play(movieFile, nes)))
+	{
+		glfwTerminate();
+		exit(1);
+	}
 
-	Initialize(nes.ppu.GetPixelPtr());
+	Initialize(ExpandFrame(nes.ppu));
+	BindKeys();
+	LoadBindings("controls.txt");
+	std::ifstream mappings("gamecontrollerdb.txt"); //sdl's community list, for pads glfw doesn't know yet
+	if(mappings.is_open())
+	{
+		std::stringstream text;
+		text << mappings.rdbuf();
+		glfwUpdateGamepadMappings(text.str().c_str());
+	}
 	glfwSetKeyCallback(window, KeyCallback);
+	glfwSetWindowFocusCallback(window, FocusCallback);
+
+	//late latching: the frame's first strobe of $4016 gets the input as it is right then, not as it was before the frame
+	nes.SetInputPoll([window](InputFrame &frame)
+	{
+		glfwPollEvents();
+		SampleInput(window, frame);
+	});
 
 	// init audio
 	Audio audio(nes.apu.GetOutput(), false);
@@ -81,18 +140,155 @@ int main(int argc, char* argv[])
 	{
 		// std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
 
-		if(!pauseEmu)
+		if(toggleTrace)
+		{
+			toggleTrace = false;
+			tracing = !tracing;
+			if(tracing)
+			{
+				trace.Clear();
+				nes.SetTrace(&trace);
+				std::cout << "tracing" << std::endl;
+			}
+			else
+			{
+				nes.SetTrace(nullptr);
+				const std::string traceFile = infile.substr(0, infile.find_last_of('.')) + ".trace";
+				if(trace.Save(traceFile))
+				{
+					std::cout << "trace saved to " << traceFile << std::endl;
+				}
+			}
+		}
+
+		if(toggleCodeLog)
+		{
+			toggleCodeLog = false;
+			codeLogging = !codeLogging;
+			if(codeLogging) //adds to what was logged before, like fceux
+			{
+				nes.SetCodeLogger(&codeLogger);
+				std::cout << "code logging" << std::endl;
+			}
+			else
+			{
+				nes.SetCodeLogger(nullptr);
+				const std::string logFile = infile.substr(0, infile.find_last_of('.'));
+				if(codeLogger.SaveCdl(logFile + ".cdl") && codeLogger.SaveHeatmap(logFile + ".heatmap.ppm"))
+				{
+					std::cout << "code log saved to " << logFile << ".cdl" << std::endl;
+					const std::vector<std::array<uint64_t, 3>> totals = codeLogger.BankTotals();
+					for(size_t bank = 0; bank < totals.size(); ++bank)
+					{
+						std::printf("bank %02X  exec %12llu  read %12llu  write %8llu\n", unsigned(bank),
+							(unsigned long long)totals[bank][AccessExec], (unsigned long long)totals[bank][AccessRead], (unsigned long long)totals[bank][AccessWrite]);
+					}
+				}
+			}
+		}
+
+		if(toggleProfile)
+		{
+			toggleProfile = false;
+			profiling = !profiling;
+			if(profiling)
+			{
+				profiler.Clear();
+				nes.SetProfiler(&profiler);
+				std::cout << "profiling" << std::endl;
+			}
+			else
+			{
+				nes.SetProfiler(nullptr);
+				const std::string profileFile = infile.substr(0, infile.find_last_of('.')) + ".profile";
+				if(profiler.SaveReport(profileFile))
+				{
+					std::cout << "profile saved to " << profileFile << std::endl;
+				}
+			}
+		}
+
+		SampleInput(window, input); //for frames that never strobe
+
+		bool stopped = false; //at a breakpoint, the rest of the frame runs once the debugger resumes
+		#ifdef ENABLE_IMGUI
+		nes.ppu.SetSnapshot(showPpuViewer ? &ppuSnapshot : nullptr);
+		nes.SetDebugger((showDebugger && movie.GetMode() == MovieOff) ? &debugger : nullptr); //a stop would split a movie frame
+		if(!showDebugger && debugger.Stopped()) //closing the windows lets the emulator go on
 		{
-			nes.AdvanceFrame(input, input2);
-			Scale3x(nes.ppu.GetPixelPtr());
+			debugger.Resume();
 		}
+		stopped = debugger.Stopped();
+		nes.SetEventLog(showEventLog ? &eventLog : nullptr);
+		#endif
+
+		if(resetPending && !stopped)
+		{
+			resetPending = false;
+			if(movie.GetMode() == MovieOff) //movies only hold pad input
+			{
+				nes.Reset();
+			}
+		}
+
+		if(stopped)
+		{
+			Scale3x(ExpandFrame(nes.ppu)); //the frame as far as it got
+		}
+		else if(!pauseEmu && rewinding && movie.GetMode() == MovieOff)
+		{
+			//a snapshot is the state after a frame, so run the one after it again to have something to show
+			if(rewind.Pop(nes))
+			{
+				nes.AdvanceFrame(input);
+				Scale3x(ExpandFrame(nes.ppu));
+			}
+		}
+		else if(!pauseEmu)
+		{
+			//a breakpoint leaves the frame half run, it isn't pushed and nothing runs after it
+			for(uint8_t x = 0; fastForward && x < 3 && !debugger.Stopped(); ++x) //4x, only every 4th frame is drawn and heard
+			{
+				movie.AdvanceFrame(nes, input, SkipVideo | SkipAudio);
+				++turboFrame;
+				if(movie.GetMode() == MovieOff && !debugger.Stopped())
+				{
+					rewind.Push(nes);
+				}
+			}
+			if(!debugger.Stopped())
+			{
+				movie.AdvanceFrame(nes, input);
+				++turboFrame;
+				if(movie.GetMode() == MovieOff && !debugger.Stopped()) //movies can't be rewound without breaking them
+				{
+					rewind.Push(nes);
+				}
+				nes.RunAhead(runAhead);
+			}
+			Scale3x(ExpandFrame(nes.ppu));
+		}
+
+		if(nes.Jammed() && !jamReported)
+		{
+			std::cout << "The cpu jammed on a KIL opcode" << std::endl;
+		}
+		jamReported = nes.Jammed(); //again after rewinding past it
+
+		#ifdef ENABLE_IMGUI
+		if(showEventLog && eventOverlay)
+		{
+			eventLog.Draw(scaledOutput.data(), texWidth, 3);
+		}
+		#endif
 
 		glClear(GL_COLOR_BUFFER_BIT);
 		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texWidth, texHeight, GL_RGBA, GL_UNSIGNED_BYTE, scaledOutput.data());
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
 
 		#ifdef ENABLE_IMGUI
-		ImguiStuff(nes);
+		stopped |= debugger.Stopped(); //the samples of a stopped frame wait for the rest of it
+		ImguiStuff(nes, ppuViewer, ppuSnapshot, debugger, eventLog);
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		#endif
@@ -100,7 +296,7 @@ int main(int argc, char* argv[])
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 
-		if(!pauseEmu || frameAdvance)
+		if((!pauseEmu || frameAdvance) && !stopped)
 		{
 			audio.StreamSource(); // framerate controlled by audio playback
 			nes.apu.sampleCount = 0;
@@ -129,6 +325,33 @@ int main(int argc, char* argv[])
 }
 
 
+int VerifyMovie(const std::string &romFile, const std::string &movieFile)
+{
+	Nes nes(romFile, BatteryCopy);
+	Movie movie;
+	if(!nes.Loaded() || !movie.Play(movieFile, nes))
+	{
+		return 1;
+	}
+
+	const auto t1 = std::chrono::steady_clock::now();
+	while(movie.GetMode() == MoviePlay && movie.GetDesyncFrame() == -1)
+	{
+		movie.AdvanceFrame(nes, InputFrame(), SkipVideo | SkipAudio);
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(t2 - t1).count();
+
+	if(movie.GetDesyncFrame() != -1)
+	{
+		std::cout << movieFile << ": desync at frame " << movie.GetDesyncFrame() << std::endl;
+		return 1;
+	}
+	std::cout << movieFile << ": " << movie.GetFrame() << " frames in sync, " << int(movie.GetFrame() / seconds) << " fps" << std::endl;
+	return 0;
+}
+
+
 void Initialize(const uint32_t *const pixelPtr)
 {
 	GLuint vao, vbo, eab, texture;
@@ -235,23 +458,27 @@ static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, i
 {
 	if(action != GLFW_REPEAT)
 	{
-		std::map<int, uint8_t> keys
+		if(key >= 0 && key <= GLFW_KEY_LAST && keyBindings[key].buttons)
 		{
-			{GLFW_KEY_Z,     0b00000001}, {GLFW_KEY_X,     0b00000010},
-			{GLFW_KEY_S,     0b00000100}, {GLFW_KEY_A,     0b00001000},
-			{GLFW_KEY_UP,    0b00010000}, {GLFW_KEY_DOWN,  0b00100000},
-			{GLFW_KEY_LEFT,  0b01000000}, {GLFW_KEY_RIGHT, 0b10000000},
-		};
-		if(keys.find(key) != keys.end()) input ^= keys.at(key);
+			uint8_t &pad = (keyBindings[key].turbo ? keyboardTurbo : keyboardPads)[keyBindings[key].pad];
+			if(action == GLFW_PRESS)
+			{
+				pad |= keyBindings[key].buttons;
+			}
+			else
+			{
+				pad &= ~keyBindings[key].buttons;
+			}
+		}
 
-		std::map<int, uint8_t> keys2
+		if(key == GLFW_KEY_TAB)
+		{
+			fastForward = (action == GLFW_PRESS);
+		}
+		if(key == GLFW_KEY_BACKSPACE)
 		{
-			{GLFW_KEY_G,  0b00000001}, {GLFW_KEY_H, 0b00000010},
-			{GLFW_KEY_Y,  0b00000100}, {GLFW_KEY_T, 0b00001000},
-			{GLFW_KEY_I,  0b00010000}, {GLFW_KEY_K, 0b00100000},
-			{GLFW_KEY_J,  0b01000000}, {GLFW_KEY_L, 0b10000000},
-		};
-		if(keys2.find(key) != keys2.end()) input2 ^= keys2.at(key);
+			rewinding = (action == GLFW_PRESS);
+		}
 
 		if(action == GLFW_PRESS)
 		{
@@ -260,6 +487,11 @@ static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, i
 				case GLFW_KEY_ESCAPE: glfwSetWindowShouldClose(window, GL_TRUE); break;
 				case GLFW_KEY_F: frameAdvance = true; pauseEmu = false; break;
 				case GLFW_KEY_G: pauseEmu = !pauseEmu; break;
+				case GLFW_KEY_F5: resetPending = true; break;
+				case GLFW_KEY_F8: toggleTrace = true; break;
+				case GLFW_KEY_F9: toggleCodeLog = true; break;
+				case GLFW_KEY_F10: toggleProfile = true; break;
+				case GLFW_KEY_R: runAhead = (runAhead + 1) % 4; std::cout << "run ahead " << +runAhead << std::endl; break;
 			}
 		}
 		// if(key == GLFW_KEY_ESCAPE)
@@ -270,6 +502,174 @@ static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, i
 }
 
 
+static void FocusCallback(GLFWwindow* window, int focused)
+{
+	if(!focused) //keys released elsewhere are never reported
+	{
+		keyboardPads.fill(0);
+		keyboardTurbo.fill(0);
+	}
+}
+
+
+void BindKeys()
+{
+	//in button order, A B select start up down left right
+	const std::array<std::array<int, 8>, 2> pads
+	{{
+		{{GLFW_KEY_Z, GLFW_KEY_X, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT}},
+		{{GLFW_KEY_G, GLFW_KEY_H, GLFW_KEY_Y, GLFW_KEY_T, GLFW_KEY_I,  GLFW_KEY_K,    GLFW_KEY_J,    GLFW_KEY_L}},
+	}};
+	const std::array<std::array<int, 2>, 2> turbo{{{{GLFW_KEY_C, GLFW_KEY_V}}, {{GLFW_KEY_B, GLFW_KEY_N}}}}; //turbo A and B
+	for(uint8_t pad = 0; pad < pads.size(); ++pad)
+	{
+		for(uint8_t button = 0; button < 8; ++button)
+		{
+			keyBindings[pads[pad][button]] = {pad, uint8_t(1 << button), false};
+		}
+		for(uint8_t button = 0; button < 2; ++button)
+		{
+			keyBindings[turbo[pad][button]] = {pad, uint8_t(1 << button), true};
+		}
+	}
+
+	gamepadBindings = {{GLFW_GAMEPAD_BUTTON_B, GLFW_GAMEPAD_BUTTON_A, GLFW_GAMEPAD_BUTTON_BACK, GLFW_GAMEPAD_BUTTON_START,
+		GLFW_GAMEPAD_BUTTON_DPAD_UP, GLFW_GAMEPAD_BUTTON_DPAD_DOWN, GLFW_GAMEPAD_BUTTON_DPAD_LEFT, GLFW_GAMEPAD_BUTTON_DPAD_RIGHT,
+		GLFW_GAMEPAD_BUTTON_Y, GLFW_GAMEPAD_BUTTON_X}};
+}
+
+
+bool LoadBindings(const std::string &path)
+{
+	std::ifstream file(path.c_str());
+	if(!file.is_open())
+	{
+		return false;
+	}
+
+	//the file replaces the defaults, so anything can be unbound
+	const std::array<std::string, 10> names{{"a", "b", "select", "start", "up", "down", "left", "right", "turboa", "turbob"}};
+	keyBindings.fill({0, 0, false});
+	gamepadBindings.fill(-1);
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while(std::getline(file, line))
+	{
+		++lineNumber;
+		std::istringstream fields(line);
+		std::string device, name;
+		int pad = 1, code = -1;
+		if(!(fields >> device) || device[0] == '#')
+		{
+			continue;
+		}
+		if(device == "key")
+		{
+			fields >> pad;
+		}
+		fields >> name >> code;
+
+		const size_t button = std::find(names.begin(), names.end(), name) - names.begin();
+		const int last = (device == "key") ? GLFW_KEY_LAST : (device == "gamepad") ? GLFW_GAMEPAD_BUTTON_LAST : -1;
+		if(button == names.size() || pad < 1 || pad > 4 || code < 0 || code > last)
+		{
+			std::cout << path << ":" << lineNumber << " is not a binding" << std::endl;
+			continue;
+		}
+
+		if(device == "key")
+		{
+			keyBindings[code] = {uint8_t(pad - 1), uint8_t(1 << (button & 7)), button >= 8}; //turbo a and b are bits 0 and 1
+		}
+		else
+		{
+			gamepadBindings[button] = code;
+		}
+	}
+	return true;
+}
+
+
+void SampleInput(GLFWwindow *window, InputFrame &frame)
+{
+	const bool turboOn = turboFrame & 2; //2 frames down, 2 up, games that wait for a release between presses see every one
+	for(uint8_t pad = 0; pad < 4; ++pad)
+	{
+		frame.pads[pad] = keyboardPads[pad] | (turboOn ? keyboardTurbo[pad] : 0);
+	}
+	PollGamepads(frame.pads, turboOn);
+	SampleMouse(window, frame);
+}
+
+
+void PollGamepads(std::array<uint8_t, 4> &pads, const bool turboOn) //joysticks 1-4 play pads 1-4, the left stick works as the d-pad
+{
+	for(int joystick = GLFW_JOYSTICK_1; joystick <= GLFW_JOYSTICK_4; ++joystick)
+	{
+		GLFWgamepadstate state;
+		if(!glfwGetGamepadState(joystick, &state)) //not connected or no mapping for it
+		{
+			continue;
+		}
+
+		uint8_t buttons = 0;
+		for(uint8_t x = 0; x < 8; ++x)
+		{
+			if(gamepadBindings[x] >= 0 && state.buttons[gamepadBindings[x]] == GLFW_PRESS)
+			{
+				buttons |= 1 << x;
+			}
+		}
+		for(uint8_t x = 8; turboOn && x < 10; ++x)
+		{
+			if(gamepadBindings[x] >= 0 && state.buttons[gamepadBindings[x]] == GLFW_PRESS)
+			{
+				buttons |= 1 << (x - 8);
+			}
+		}
+		const float stickX = state.axes[GLFW_GAMEPAD_AXIS_LEFT_X];
+		const float stickY = state.axes[GLFW_GAMEPAD_AXIS_LEFT_Y];
+		buttons |= (stickY < -0.5f) << 4 | (stickY > 0.5f) << 5 | (stickX < -0.5f) << 6 | (stickX > 0.5f) << 7;
+		pads[joystick - GLFW_JOYSTICK_1] |= buttons;
+	}
+}
+
+
+void SampleMouse(GLFWwindow *window, InputFrame &frame) //zapper and arkanoid knob
+{
+	#ifdef ENABLE_IMGUI
+	if(ImGui::GetIO().WantCaptureMouse) //clicks on the windows aren't shots
+	{
+		frame.pointerX = frame.pointerY = -1;
+		frame.trigger = false;
+		return;
+	}
+	#endif
+
+	double x, y;
+	int width, height;
+	glfwGetCursorPos(window, &x, &y);
+	glfwGetWindowSize(window, &width, &height);
+	frame.pointerX = (x >= 0 && x < width) ? int16_t(x * 256 / width) : -1;
+	frame.pointerY = (y >= 0 && y < height) ? int16_t(y * 240 / height) : -1;
+	frame.paddle = 0x62 + std::min(std::max(int(x * 256 / width), 0), 255) * (0xF2 - 0x62) / 255;
+	frame.trigger = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+	if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) //a shot away from the screen, to reload
+	{
+		frame.pointerX = frame.pointerY = -1;
+		frame.trigger = true;
+	}
+}
+
+
+const uint32_t* ExpandFrame(const Ppu &ppu)
+{
+	IndexedToRgba(ppu.GetIndexPtr(), ppu.GetEmphasisPtr(), ppu.GetPaletteLut(), frameRgba.data());
+	return frameRgba.data();
+}
+
+
 void Scale3x(const uint32_t *const pixelPtr)
 {
 	auto *pOutput = scaledOutput.data();
@@ -292,7 +692,7 @@ void Scale3x(const uint32_t *const pixelPtr)
 
 
 #ifdef ENABLE_IMGUI
-void ImguiStuff(const Nes &nes)
+void ImguiStuff(Nes &nes, PpuViewer &viewer, const PpuSnapshot &snapshot, Debugger &debugger, const EventLog &eventLog)
 {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -314,7 +714,299 @@ void ImguiStuff(const Nes &nes)
 		frameAdvance = true;
 		pauseEmu = false;
 	}
+	const char *devices[] = {"None", "Pad", "Four Score", "Zapper", "Arkanoid"};
+	for(uint8_t port = 0; port < 2; ++port)
+	{
+		int device = nes.GetInputDevice(port);
+		if(ImGui::Combo(port ? "Port 2" : "Port 1", &device, devices, 5))
+		{
+			nes.SetInputDevice(port, InputDevice(device));
+		}
+	}
+	ImGui::Checkbox("PPU viewer", &showPpuViewer);
+	ImGui::Checkbox("Debugger", &showDebugger);
+	ImGui::Checkbox("Event log", &showEventLog);
 
     ImGui::End();
+
+	if(showPpuViewer)
+	{
+		PpuWindows(viewer, snapshot);
+	}
+	if(showDebugger)
+	{
+		DebuggerWindows(nes, debugger);
+		MemoryWindow(nes);
+	}
+	if(showEventLog)
+	{
+		EventWindow(eventLog);
+	}
+}
+
+
+void PpuWindows(PpuViewer &viewer, const PpuSnapshot &snapshot)
+{
+	static GLuint nametableTexture = 0, patternTexture = 0, spriteTexture = 0;
+	static uint32_t lastFrame = 0;
+	static int patternPalette = 0, lastPalette = 0;
+
+	//only a new snapshot or another palette needs work, paused frames cost nothing
+	if(snapshot.frame != lastFrame || patternPalette != lastPalette || !nametableTexture)
+	{
+		lastFrame = snapshot.frame;
+		lastPalette = patternPalette;
+		viewer.SetPatternPalette(patternPalette);
+		if(viewer.Update(snapshot) || !nametableTexture)
+		{
+			UploadTexture(nametableTexture, viewer.GetNametables(), 512, 480);
+			UploadTexture(patternTexture, viewer.GetPatternTables(), 256, 128);
+			UploadTexture(spriteTexture, viewer.GetSprites(), 64, 128);
+		}
+	}
+
+	ImGui::Begin("Nametables", &showPpuViewer);
+	ImGui::Image(reinterpret_cast<ImTextureID>(uintptr_t(nametableTexture)), ImVec2(512, 480));
+	{
+		//the visible area at the top of the frame, wrapping around the edges
+		const ImVec2 origin = ImGui::GetItemRectMin();
+		const std::array<uint16_t, 2> scroll = viewer.ScrollPosition();
+		ImDrawList *drawList = ImGui::GetWindowDrawList();
+		drawList->PushClipRect(origin, ImGui::GetItemRectMax(), true);
+		for(int y = scroll[1] - 480; y <= scroll[1]; y += 480)
+		{
+			for(int x = scroll[0] - 512; x <= scroll[0]; x += 512)
+			{
+				drawList->AddRect(ImVec2(origin.x + x, origin.y + y), ImVec2(origin.x + x + 256, origin.y + y + 240), IM_COL32(255, 0, 0, 255));
+			}
+		}
+		drawList->PopClipRect();
+	}
+	ImGui::End();
+
+	ImGui::Begin("Pattern tables", &showPpuViewer);
+	ImGui::Image(reinterpret_cast<ImTextureID>(uintptr_t(patternTexture)), ImVec2(512, 256));
+	ImGui::SliderInt("Palette", &patternPalette, 0, 7);
+	ImGui::End();
+
+	ImGui::Begin("Sprites", &showPpuViewer);
+	ImGui::Image(reinterpret_cast<ImTextureID>(uintptr_t(spriteTexture)), ImVec2(128, 256));
+	ImGui::SameLine();
+	ImGui::BeginChild("oam", ImVec2(0, 256));
+	for(uint8_t x = 0; x < 64; ++x)
+	{
+		const uint8_t *entry = &snapshot.oam[x * 4];
+		ImGui::Text("%02u x:%3u y:%3u tile:%02X attr:%02X", x, entry[3], entry[0], entry[1], entry[2]);
+	}
+	ImGui::EndChild();
+	ImGui::End();
+
+	ImGui::Begin("Palette", &showPpuViewer);
+	for(uint8_t x = 0; x < 32; ++x)
+	{
+		const uint8_t index = snapshot.palette[x] & 0x3F;
+		char label[16];
+		std::snprintf(label, sizeof(label), "%02X:%02X", x, index);
+		if(x & 15)
+		{
+			ImGui::SameLine();
+		}
+		ImGui::ColorButton(label, ImGui::ColorConvertU32ToFloat4(snapshot.colors[index]), 0, ImVec2(20, 20));
+	}
+	ImGui::End();
+}
+
+
+void DebuggerWindows(Nes &nes, Debugger &debugger)
+{
+	static char low[5] = "8000", high[5] = "", condition[128] = "";
+	static bool exec = true, read = false, write = false;
+	static int space = CpuSpace;
+
+	ImGui::Begin("Debugger", &showDebugger);
+	const NesInfo info = nes.GetInfo();
+	if(debugger.Stopped())
+	{
+		ImGui::Text("Stopped, %s", debugger.Reason().c_str());
+		if(ImGui::Button("Continue"))
+		{
+			debugger.Resume();
+		}
+		ImGui::SameLine();
+		if(ImGui::Button("Step"))
+		{
+			debugger.Step();
+		}
+	}
+	else if(ImGui::Button("Break"))
+	{
+		debugger.Step(); //stops after the instruction that's next
+	}
+	ImGui::Text("A:%02X X:%02X Y:%02X S:%02X  %03u:%03u", info.rA, info.rX, info.rY, info.rS, nes.ppu.GetScanlineV(), nes.ppu.GetScanlineH());
+	ImGui::Separator();
+
+	//a breakpoint on one address or a range, the condition is optional
+	ImGui::PushItemWidth(40);
+	ImGui::InputText("-", low, sizeof(low), ImGuiInputTextFlags_CharsHexadecimal);
+	ImGui::SameLine();
+	ImGui::InputText("##high", high, sizeof(high), ImGuiInputTextFlags_CharsHexadecimal);
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	ImGui::RadioButton("CPU", &space, CpuSpace);
+	ImGui::SameLine();
+	ImGui::RadioButton("PPU", &space, PpuSpace);
+	ImGui::Checkbox("Exec", &exec);
+	ImGui::SameLine();
+	ImGui::Checkbox("Read", &read);
+	ImGui::SameLine();
+	ImGui::Checkbox("Write", &write);
+	ImGui::InputText("Condition", condition, sizeof(condition));
+	if(ImGui::Button("Add") && low[0] && (exec || read || write))
+	{
+		Breakpoint breakpoint;
+		breakpoint.low = std::strtoul(low, nullptr, 16);
+		breakpoint.high = high[0] ? std::strtoul(high, nullptr, 16) : breakpoint.low;
+		breakpoint.type = (exec ? BreakExec : 0) | (read ? BreakRead : 0) | (write ? BreakWrite : 0);
+		breakpoint.space = DebugSpace(space);
+		breakpoint.condition = condition;
+		debugger.Add(breakpoint);
+	}
+	ImGui::Separator();
+
+	for(size_t x = 0; x < debugger.Breakpoints().size(); ++x)
+	{
+		const Breakpoint &breakpoint = debugger.Breakpoints()[x];
+		ImGui::PushID(x);
+		bool enabled = breakpoint.enabled;
+		if(ImGui::Checkbox("##enabled", &enabled))
+		{
+			debugger.Enable(x, enabled);
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s $%04X-$%04X %c%c%c %6u %s", breakpoint.space == CpuSpace ? "cpu" : "ppu", breakpoint.low, breakpoint.high,
+			(breakpoint.type & BreakExec) ? 'x' : '-', (breakpoint.type & BreakRead) ? 'r' : '-', (breakpoint.type & BreakWrite) ? 'w' : '-',
+			breakpoint.hits, breakpoint.condition.c_str());
+		ImGui::SameLine();
+		const bool remove = ImGui::SmallButton("Remove");
+		ImGui::PopID();
+		if(remove)
+		{
+			debugger.Remove(x);
+			break;
+		}
+	}
+	ImGui::End();
+}
+
+
+void MemoryWindow(Nes &nes)
+{
+	static int space = CpuSpace;
+	static char address[5] = "0000", value[3] = "";
+
+	ImGui::Begin("Memory", &showDebugger);
+	ImGui::RadioButton("CPU", &space, CpuSpace);
+	ImGui::SameLine();
+	ImGui::RadioButton("PPU", &space, PpuSpace);
+
+	ImGui::PushItemWidth(40);
+	ImGui::InputText("Address", address, sizeof(address), ImGuiInputTextFlags_CharsHexadecimal);
+	ImGui::SameLine();
+	ImGui::InputText("Value", value, sizeof(value), ImGuiInputTextFlags_CharsHexadecimal);
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	if(ImGui::Button("Write") && address[0] && value[0])
+	{
+		const uint16_t target = std::strtoul(address, nullptr, 16);
+		const uint8_t data = std::strtoul(value, nullptr, 16);
+		if(space == CpuSpace)
+		{
+			nes.DebugWrite(target, data);
+		}
+		else
+		{
+			nes.ppu.DebugWrite(target, data);
+		}
+	}
+
+	//only the visible rows are read, registers show as 0 on the cpu side
+	ImGui::BeginChild("dump", ImVec2(0, 0));
+	ImGuiListClipper clipper;
+	clipper.Begin((space == CpuSpace ? 0x10000 : 0x4000) / 16);
+	while(clipper.Step())
+	{
+		for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+		{
+			char line[8 + 16 * 3];
+			int length = std::snprintf(line, sizeof(line), "%04X:", row * 16);
+			for(uint8_t x = 0; x < 16; ++x)
+			{
+				const uint16_t a = row * 16 + x;
+				length += std::snprintf(line + length, sizeof(line) - length, " %02X", space == CpuSpace ? nes.DebugRead(a) : nes.ppu.DebugRead(a));
+			}
+			ImGui::TextUnformatted(line);
+		}
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+
+void EventWindow(const EventLog &eventLog)
+{
+	const std::vector<PpuEvent> &events = eventLog.Events();
+
+	ImGui::Begin("Events", &showEventLog);
+	ImGui::Checkbox("Show on frame", &eventOverlay);
+	ImGui::SameLine();
+	ImGui::Text("%u events", unsigned(events.size()));
+	if(eventLog.Dropped())
+	{
+		ImGui::SameLine();
+		ImGui::Text("(%u dropped)", eventLog.Dropped());
+	}
+
+	ImGui::BeginChild("events", ImVec2(0, 0));
+	ImGuiListClipper clipper;
+	clipper.Begin(events.size());
+	while(clipper.Step())
+	{
+		for(int x = clipper.DisplayStart; x < clipper.DisplayEnd; ++x)
+		{
+			const PpuEvent &event = events[x];
+			const ImVec4 color = ImGui::ColorConvertU32ToFloat4(EventLog::colors[event.type]);
+			if(event.type == EventIrq)
+			{
+				ImGui::TextColored(color, "%3u %3u  %-6s", event.scanline, event.dot, EventLog::Name(event.type));
+			}
+			else
+			{
+				ImGui::TextColored(color, "%3u %3u  %-6s $%04X = %02X", event.scanline, event.dot, EventLog::Name(event.type), event.address, event.value);
+			}
+		}
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+
+void UploadTexture(GLuint &texture, const uint32_t *pixels, const int width, const int height)
+{
+	GLint bound; //the emulator's own texture has to stay bound
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+	if(!texture)
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+	glBindTexture(GL_TEXTURE_2D, bound);
 }
 #endif
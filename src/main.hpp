@@ -1,23 +1,61 @@
 #pragma once
 
 #include "nes.hpp"
+#include "movie.hpp"
+#include "rewind.hpp"
+#include "ppuview.hpp"
 
 
+int VerifyMovie(const std::string &romFile, const std::string &movieFile);
 void Initialize(const uint32_t *const pixelPtr);
 GLuint CreateProgram();
 GLuint LoadAndCompileShader(const std::string &shaderName, GLenum shaderType);
 static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
-
+static void FocusCallback(GLFWwindow* window, int focused);
+
+void BindKeys();
+bool LoadBindings(const std::string &path); //"key pad button glfwkey" and "gamepad button glfwbutton" lines, turboa and turbob too. false keeps the defaults
+void SampleInput(GLFWwindow *window, InputFrame &frame);
+void PollGamepads(std::array<uint8_t, 4> &pads, const bool turboOn);
+void SampleMouse(GLFWwindow *window, InputFrame &frame);
+const uint32_t* ExpandFrame(const Ppu &ppu); //the indexed frame in rgba
 void Scale3x(const uint32_t *const pixelPtr);
 
 #ifdef ENABLE_IMGUI
-void ImguiStuff(const Nes &nes); //ImGuiIO &io
+void ImguiStuff(Nes &nes, PpuViewer &viewer, const PpuSnapshot &snapshot, Debugger &debugger, const EventLog &eventLog); //ImGuiIO &io
+void PpuWindows(PpuViewer &viewer, const PpuSnapshot &snapshot);
+void DebuggerWindows(Nes &nes, Debugger &debugger);
+void MemoryWindow(Nes &nes);
+void EventWindow(const EventLog &eventLog);
+void UploadTexture(GLuint &texture, const uint32_t *pixels, const int width, const int height);
+
+bool showPpuViewer = false; //the snapshot is only taken while the windows are open
+bool showDebugger = false;  //breakpoints are only checked while the windows are open
+bool showEventLog = false;  //events are only recorded while the window is open
+bool eventOverlay = true;
 #endif
 
-uint8_t input = 0, input2 = 0;
+struct KeyBinding
+{
+	uint8_t pad, buttons; //no buttons = unbound
+	bool turbo;
+};
+
+InputFrame input;
+std::array<uint8_t, 4> keyboardPads{}; //held keys, set on press and cleared on release or focus loss
+std::array<uint8_t, 4> keyboardTurbo{}; //same for the turbo keys, they press their buttons every other 2 frames
+std::array<KeyBinding, GLFW_KEY_LAST + 1> keyBindings{}; //by glfw key, built once by BindKeys
+std::array<int, 10> gamepadBindings; //glfw gamepad button for each nes button then turbo a and b, -1 = none
+uint32_t turboFrame = 0; //frames run, the turbo phase
 
+std::array<uint32_t, 256 * 240> frameRgba;
 std::array<uint32_t, 256*3 * 240*3> scaledOutput;
 const int texWidth = 256*3;
 const int texHeight = 240*3;
 
-bool pauseEmu = false, frameAdvance = false;
+bool pauseEmu = false, frameAdvance = false, fastForward = false, rewinding = false; //tab, backspace held
+uint8_t runAhead = 0; //frames, R cycles through 0-3
+bool toggleTrace = false; //F8, saved next to the rom for nestrace
+bool toggleCodeLog = false; //F9, the .cdl and a heatmap of the prg are saved next to the rom
+bool toggleProfile = false; //F10, the .profile report is saved next to the rom
+bool resetPending = false; //F5, between frames and not while a movie runs
@@ -0,0 +1,1024 @@
+#include <algorithm>
+
+#include "nes.hpp"
+
+
+void Nes::MapperInit() //power-on state for mappers that don't match the cart defaults
+{
+	switch(type)
+	{
+		case EKROM:
+			apu.expansion.SetChip(Mmc5Chip);
+			ppu.SplitSpritePattern(true);
+			prgRamWritable = false;
+			MMC5PrgUpdate();
+			MMC5ChrUpdate();
+		break;
+
+		case PNROM:
+			pPrgBank[1] = prgRom.data() + prgRom.size() - 0x6000;
+			ppu.SetChrLatch(false);
+		break;
+
+		case FKROM:
+			ppu.SetChrLatch(true);
+		break;
+
+		case N_163:
+			apu.expansion.SetChip(N163Chip);
+		break;
+
+		case VRC_6a: case VRC_6b:
+			apu.expansion.SetChip(Vrc6Chip);
+		break;
+
+		case JLROM:
+			apu.expansion.SetChip(Sunsoft5BChip);
+			prgRamWritable = false; //rom bank 0 at $6000
+			for(int x = 0; x < 4; ++x)
+			{
+				pPrgRamBank[x] = prgRom.data() + x * 0x800;
+			}
+		break;
+
+		default:
+		break;
+	}
+}
+
+
+void Nes::Addons()
+{
+	switch(type)
+	{
+		case UNROM:
+			pPrgBank[0] = &prgRom[(dataBus & 0b1111) * 0x4000];
+			pPrgBank[1] = pPrgBank[0] + 0x2000;
+		break;
+
+		case CNROM:
+			ppu.SetPatternBanks8(dataBus & 0b0011);
+		break;
+
+		case AOROM:
+			pPrgBank[0] = &prgRom[(dataBus & 0b0111) * 0x8000];
+			pPrgBank[1] = pPrgBank[0] + 0x2000;
+			pPrgBank[2] = pPrgBank[0] + 0x4000;
+			pPrgBank[3] = pPrgBank[0] + 0x6000;
+
+			if(dataBus & 0b00010000)
+			{
+				ppu.SetNametableArrangement({B,B,B,B});
+			}
+			else
+			{
+				ppu.SetNametableArrangement({A,A,A,A});
+			}
+		break;
+
+		case SFROM: MMC1Registers(); break;
+		case TLROM: MMC3Registers(); break;
+		case EKROM: MMC5Registers(); break;
+		case PNROM: case FKROM: MMC2Registers(); break;
+		case N_163: N163Registers(); break;
+		case VRC_4: VRC4Registers(); break;
+		case VRC_6a: case VRC_6b: VRC6Registers(); break;
+		case JLROM: FME7Registers(); break;
+		default: break;
+	}
+}
+
+
+void Nes::CartRegisterRead() //$4020-$5FFF
+{
+	switch(type)
+	{
+		case EKROM: MMC5Read(); break;
+		case N_163: N163Read(); break;
+		default: break;
+	}
+}
+
+
+void Nes::CartRegisterWrite() //$4020-$5FFF
+{
+	switch(type)
+	{
+		case EKROM: MMC5Registers(); break;
+		case N_163: N163Registers(); break;
+		default: break;
+	}
+}
+
+
+uint8_t* Nes::PrgBank8(const uint16_t bank) //wraps around like the missing upper address lines would
+{
+	return prgRom.data() + ((bank << 13) % prgRom.size());
+}
+
+
+void Nes::MMC1Registers()
+{
+	if(mmc1.lastWrittenTo != cycleCount - 1) //compare with previous write to disallow consecutive writes
+	{
+		if(dataBus & 0x80)
+		{
+			mmc1.shiftReg = 0b100000;
+			mmc1.prgMode = 0b11;
+			pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
+			pPrgBank[1] = pPrgBank[0] + 8 * 1024;
+			pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
+			pPrgBank[3] = pPrgBank[2] + 8 * 1024;
+		}
+		else
+		{
+			mmc1.shiftReg |= (dataBus & 1) << 6;
+			mmc1.shiftReg >>= 1;
+			if(mmc1.shiftReg & 1)
+			{
+				mmc1.shiftReg >>= 1;
+				switch(addressBus >> 13)
+				{
+					case 0x8000 >> 13:
+						switch(mmc1.shiftReg & 0b11)
+						{
+							case 0: ppu.SetNametableArrangement({A,A,A,A}); break;
+							case 1: ppu.SetNametableArrangement({B,B,B,B}); break;
+							case 2: ppu.SetNametableArrangement({A,B,A,B}); break;
+							case 3: ppu.SetNametableArrangement({A,A,B,B}); break;
+						}
+
+						mmc1.prgMode = (mmc1.shiftReg >> 2) & 0b11;
+						switch(mmc1.prgMode)
+						{
+							case 0: case 1: //32k mode
+								pPrgBank[0] = prgRom.data() + ((mmc1.prg & 0b11110) << 14);
+								pPrgBank[2] = pPrgBank[0] + 16 * 1024;
+							break;
+							case 2: //low bank fixed, high switchable
+								pPrgBank[0] = prgRom.data();
+								pPrgBank[2] = prgRom.data() + (mmc1.prg << 14);
+							break;
+							case 3: //high bank fixed, low switchable
+								pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
+								pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
+							break;
+						}
+						pPrgBank[1] = pPrgBank[0] + 8 * 1024;
+						pPrgBank[3] = pPrgBank[2] + 8 * 1024;
+
+						mmc1.chrMode = mmc1.shiftReg >> 4;
+						if(mmc1.chrMode == 1)
+						{
+							ppu.SetPatternBanks4(0, mmc1.chr0);
+							ppu.SetPatternBanks4(1, mmc1.chr1);
+						}
+						else
+						{
+							ppu.SetPatternBanks8(mmc1.chr0 >> 1);
+						}
+					break;
+
+					case 0xA000 >> 13:
+						mmc1.chr0 = mmc1.shiftReg;
+						if(mmc1.chrMode == 1)
+						{
+							ppu.SetPatternBanks4(0, mmc1.chr0);
+						}
+						else
+						{
+							ppu.SetPatternBanks8(mmc1.chr0 >> 1);
+						}
+					break;
+
+					case 0xC000 >> 13:
+						mmc1.chr1 = mmc1.shiftReg;
+						if(mmc1.chrMode == 1)
+						{
+							ppu.SetPatternBanks4(1, mmc1.chr1);
+						}
+					break;
+
+					case 0xE000 >> 13:
+						mmc1.prg = mmc1.shiftReg & 0b01111;
+						switch(mmc1.prgMode)
+						{
+							case 0: case 1: //32k mode
+								pPrgBank[0] = prgRom.data() + ((mmc1.prg & 0b11110) << 14);
+								pPrgBank[2] = pPrgBank[0] + 16 * 1024;
+							break;
+							case 2: //low bank fixed, high switchable
+								pPrgBank[0] = prgRom.data();
+								pPrgBank[2] = prgRom.data() + (mmc1.prg << 14);
+							break;
+							case 3: //high bank fixed, low switchable
+								pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
+								pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
+							break;
+						}
+						pPrgBank[1] = pPrgBank[0] + 8 * 1024;
+						pPrgBank[3] = pPrgBank[2] + 8 * 1024;
+						mmc1.wramEnable = mmc1.shiftReg & 0b10000;
+					break;
+				}
+				mmc1.shiftReg = 0b100000;
+			}
+		}
+	}
+	mmc1.lastWrittenTo = cycleCount;
+}
+
+
+void Nes::MMC2Registers() //also mmc4, the chr latches live in the ppu since they're switched by its fetches
+{
+	switch(addressBus >> 12)
+	{
+		case 0xA:
+			if(type == PNROM) //8kb at $8000
+			{
+				pPrgBank[0] = PrgBank8(dataBus & 0b1111);
+			}
+			else //16kb at $8000
+			{
+				pPrgBank[0] = PrgBank8((dataBus & 0b1111) << 1);
+				pPrgBank[1] = pPrgBank[0] + 0x2000;
+			}
+		break;
+
+		case 0xB: case 0xC: case 0xD: case 0xE:
+			ppu.SetChrLatchBank((addressBus >> 12) - 0xB, dataBus & 0b00011111);
+		break;
+
+		case 0xF:
+			if(dataBus & 1)
+			{
+				ppu.SetNametableArrangement({A, A, B, B});
+			}
+			else
+			{
+				ppu.SetNametableArrangement({A, B, A, B});
+			}
+		break;
+	}
+}
+
+
+void Nes::MMC3Registers()
+{
+	switch(((addressBus >> 12) & 0b0110) | (addressBus & 1))
+	{
+		case 0: //8000
+			mmc3.bankRegSelect = dataBus & 0b0111;
+			mmc3.prgMode = dataBus & 0b01000000;
+			mmc3.chrMode = dataBus & 0b10000000;
+
+			pPrgBank[mmc3.prgMode << 1] = &prgRom[mmc3.bankReg[6] << 13];
+			pPrgBank[!mmc3.prgMode << 1] = &prgRom[prgRom.size() - 16 * 1024];
+
+			ppu.SetPatternBanks2((mmc3.chrMode << 1)    , mmc3.bankReg[0]);
+			ppu.SetPatternBanks2((mmc3.chrMode << 1) | 1, mmc3.bankReg[1]);
+
+			ppu.SetPatternBanks1((!mmc3.chrMode << 2)    , mmc3.bankReg[2]);
+			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 1, mmc3.bankReg[3]);
+			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 2, mmc3.bankReg[4]);
+			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 3, mmc3.bankReg[5]);
+
+		break;
+
+		case 1: //8001
+			mmc3.bankReg[mmc3.bankRegSelect] = dataBus;
+
+			switch(mmc3.bankRegSelect)
+			{
+				case 0: case 1:
+					mmc3.bankReg[mmc3.bankRegSelect] >>= 1;
+					ppu.SetPatternBanks2((mmc3.chrMode << 1) | mmc3.bankRegSelect, mmc3.bankReg[mmc3.bankRegSelect]);
+				break;
+
+				case 2: case 3: case 4: case 5:
+					ppu.SetPatternBanks1((!mmc3.chrMode << 2) | (mmc3.bankRegSelect - 2), mmc3.bankReg[mmc3.bankRegSelect]);
+				break;
+
+				case 6:
+					mmc3.bankReg[6] &= 0b00111111;
+					pPrgBank[mmc3.prgMode << 1] = &prgRom[mmc3.bankReg[6] << 13];
+				break;
+
+				case 7:
+					mmc3.bankReg[7] &= 0b00111111;
+					pPrgBank[1] = &prgRom[mmc3.bankReg[7] << 13];
+				break;
+			}
+		break;
+
+		case 2: //A000
+			if(dataBus & 1)
+			{
+				ppu.SetNametableArrangement({A, A, B, B});
+			}
+			else
+			{
+				ppu.SetNametableArrangement({A, B, A, B});
+			}
+		break;
+
+		case 3: //A001
+		break;
+
+		case 4: //C000
+			mmc3.irqLatch = dataBus;
+		break;
+
+		case 5: //C001
+			mmc3.irqReload = true;
+			//also set counter to 0?
+		break;
+
+		case 6: //E000
+			mmc3.irqEnable = false;
+			mmc3.irqPending = false;
+		break;
+
+		case 7: //E001
+			mmc3.irqEnable = true;
+		break;
+	}
+}
+
+
+bool Nes::MMC3Interrupt()
+{
+	//todo: investigate revision differences
+
+	mmc3.A12[2] = mmc3.A12[1];
+	mmc3.A12[1] = mmc3.A12[0];
+	mmc3.A12[0] = ppu.GetA12();
+
+	if(mmc3.A12[0] && !(mmc3.A12[1] | mmc3.A12[2])) //clock irq via A12 0 -> 0 -> 1 change
+	{
+		if(mmc3.irqReload || mmc3.irqCounter == 0)
+		{
+			mmc3.irqCounter = mmc3.irqLatch;
+			mmc3.irqReload = false;
+		}
+		else
+		{
+			--mmc3.irqCounter;
+		}
+
+		if(mmc3.irqCounter == 0)
+		{
+			mmc3.irqPending |= mmc3.irqEnable;
+		}
+	}
+
+	return mmc3.irqPending;
+}
+
+
+void Nes::MMC5Registers()
+{
+	if(addressBus >= 0x8000) //prg ram can be banked into $8000-$DFFF
+	{
+		const uint8_t window = (addressBus >> 13) & 0b11;
+		if(mmc5.prgWindowRam[window] && prgRamWritable)
+		{
+			pPrgBank[window][addressBus & 0x1FFF] = dataBus;
+		}
+		return;
+	}
+
+	if(addressBus >= 0x5C00)
+	{
+		if(mmc5.exRamMode != 3) //todo: modes 0/1 only accept writes while rendering
+		{
+			mmc5.exRam[addressBus & 0x3FF] = dataBus;
+		}
+		return;
+	}
+
+	switch(addressBus)
+	{
+		case 0x5000: case 0x5002: case 0x5003: case 0x5004: case 0x5006: case 0x5007:
+		case 0x5010: case 0x5011: case 0x5015:
+			apu.expansion.Mmc5Write(addressBus, dataBus);
+		break;
+
+		case 0x5100:
+			mmc5.prgMode = dataBus & 0b11;
+			MMC5PrgUpdate();
+		break;
+
+		case 0x5101:
+			mmc5.chrMode = dataBus & 0b11;
+			MMC5ChrUpdate();
+		break;
+
+		case 0x5102:
+			mmc5.ramProtect1 = dataBus & 0b11;
+			prgRamWritable = mmc5.ramProtect1 == 0b10 && mmc5.ramProtect2 == 0b01;
+		break;
+
+		case 0x5103:
+			mmc5.ramProtect2 = dataBus & 0b11;
+			prgRamWritable = mmc5.ramProtect1 == 0b10 && mmc5.ramProtect2 == 0b01;
+		break;
+
+		case 0x5104:
+			mmc5.exRamMode = dataBus & 0b11;
+			ppu.SetExAttribute((mmc5.exRamMode == 1) ? mmc5.exRam.data() : nullptr, mmc5.chrHigh);
+			MMC5SplitUpdate();
+		break;
+
+		case 0x5105:
+			MMC5NametableUpdate(dataBus);
+		break;
+
+		case 0x5106:
+			std::fill(mmc5.fill.begin(), mmc5.fill.begin() + 960, dataBus);
+		break;
+
+		case 0x5107:
+			std::fill(mmc5.fill.begin() + 960, mmc5.fill.end(), (dataBus & 0b11) * 0x55);
+		break;
+
+		case 0x5113: case 0x5114: case 0x5115: case 0x5116: case 0x5117:
+			mmc5.prg[addressBus - 0x5113] = dataBus;
+			MMC5PrgUpdate();
+		break;
+
+		case 0x5120: case 0x5121: case 0x5122: case 0x5123: case 0x5124: case 0x5125: case 0x5126: case 0x5127:
+		case 0x5128: case 0x5129: case 0x512A: case 0x512B:
+			mmc5.chr[addressBus - 0x5120] = dataBus | (mmc5.chrHigh << 8);
+			mmc5.chrSetB = addressBus >= 0x5128;
+			MMC5ChrUpdate();
+		break;
+
+		case 0x5130:
+			mmc5.chrHigh = dataBus & 0b11;
+			if(mmc5.exRamMode == 1)
+			{
+				ppu.SetExAttribute(mmc5.exRam.data(), mmc5.chrHigh);
+			}
+		break;
+
+		case 0x5200: mmc5.splitControl = dataBus; MMC5SplitUpdate(); break;
+		case 0x5201: mmc5.splitScroll = dataBus;  MMC5SplitUpdate(); break;
+		case 0x5202: mmc5.splitBank = dataBus;    MMC5SplitUpdate(); break;
+
+		case 0x5203: mmc5.irqCompare = dataBus;         break;
+		case 0x5204: mmc5.irqEnable = dataBus & 0x80;   break;
+		case 0x5205: mmc5.multiplicand = dataBus;       break;
+		case 0x5206: mmc5.multiplier = dataBus;         break;
+	}
+}
+
+
+void Nes::MMC5Read()
+{
+	if(addressBus >= 0x5C00)
+	{
+		if(mmc5.exRamMode >= 2)
+		{
+			dataBus = mmc5.exRam[addressBus & 0x3FF];
+		}
+		return;
+	}
+
+	switch(addressBus)
+	{
+		case 0x5015: dataBus = apu.expansion.Mmc5StatusRead(); break;
+
+		case 0x5204:
+			MMC5Interrupt();
+			dataBus = (mmc5.irqPending << 7) | ((mmc5.irqLine >= 0) << 6);
+			mmc5.irqPending = false; //reading acknowledges the irq
+			ScheduleIrq(MapperIrq, cycleCount);
+		break;
+
+		case 0x5205: dataBus = mmc5.multiplicand * mmc5.multiplier;        break;
+		case 0x5206: dataBus = (mmc5.multiplicand * mmc5.multiplier) >> 8; break;
+	}
+}
+
+
+void Nes::MMC5PrgUpdate()
+{
+	const uint8_t ramBanks = prgRam.size() >> 13;
+
+	for(int x = 0; x < 4; ++x)
+	{
+		pPrgRamBank[x] = prgRam.data() + (((mmc5.prg[0] & 0b0111) % ramBanks) << 13) + x * 0x800;
+	}
+
+	for(uint8_t window = 0; window < 4; ++window)
+	{
+		uint8_t reg = 4, bank = 0;
+		switch(mmc5.prgMode)
+		{
+			case 0: //32kb
+				reg = 4;
+				bank = (mmc5.prg[4] & 0b01111100) | window;
+			break;
+			case 1: //16kb + 16kb
+				reg = 2 + (window & 0b10);
+				bank = (mmc5.prg[reg] & 0b01111110) | (window & 1);
+			break;
+			case 2: //16kb + 8kb + 8kb
+				reg = (window < 2) ? 2 : window + 1;
+				bank = (window < 2) ? (mmc5.prg[2] & 0b01111110) | window : mmc5.prg[reg] & 0x7F;
+			break;
+			case 3: //8kb x 4
+				reg = window + 1;
+				bank = mmc5.prg[reg] & 0x7F;
+			break;
+		}
+
+		//bit 7 selects rom, $5117 always maps rom
+		mmc5.prgWindowRam[window] = reg != 4 && !(mmc5.prg[reg] & 0x80);
+		if(mmc5.prgWindowRam[window])
+		{
+			pPrgBank[window] = prgRam.data() + (((bank & 0b0111) % ramBanks) << 13);
+		}
+		else
+		{
+			pPrgBank[window] = PrgBank8(bank);
+		}
+	}
+}
+
+
+void Nes::MMC5ChrUpdate()
+{
+	//8x16 sprites fetch from the A set ($5120-$5127) and the background from the B set ($5128-$512B),
+	//otherwise everything uses whichever set was written last
+	const uint8_t pages = 8 >> mmc5.chrMode; //1kb pages per bank
+	for(uint8_t x = 0; x < 8; ++x)
+	{
+		const uint8_t reg = (x / pages + 1) * pages - 1;
+		const uint16_t bankA = mmc5.chr[reg] * pages + x % pages;
+		const uint16_t bankB = mmc5.chr[8 | (reg & 0b11)] * pages + x % pages;
+
+		if(mmc5.sprite8x16)
+		{
+			ppu.SetPatternBanks1(x, bankB);
+			ppu.SetSpritePatternBanks1(x, bankA);
+		}
+		else
+		{
+			ppu.SetPatternBanks1(x, mmc5.chrSetB ? bankB : bankA);
+			ppu.SetSpritePatternBanks1(x, mmc5.chrSetB ? bankB : bankA);
+		}
+	}
+}
+
+
+void Nes::MMC5NametableUpdate(const uint8_t data)
+{
+	for(uint8_t x = 0; x < 4; ++x)
+	{
+		switch((data >> (x * 2)) & 0b11)
+		{
+			case 0: ppu.SetNametable(x, A);                 break;
+			case 1: ppu.SetNametable(x, B);                 break;
+			case 2: ppu.SetNametable(x, mmc5.exRam.data()); break;
+			case 3: ppu.SetNametable(x, mmc5.fill.data());  break;
+		}
+	}
+}
+
+
+bool Nes::MMC5Interrupt()
+{
+	//the scanline counter follows the ppu position instead of watching its fetches.
+	//MMC5NextIrq makes sure this runs on the compare line and when the frame ends
+	const uint16_t line = ppu.GetScanlineV();
+	if(!ppu.RenderingEnabled() || line >= 240)
+	{
+		mmc5.irqLine = -1;
+	}
+	else
+	{
+		//coming into the frame past the compare line, like rendering switched on late, doesn't count as reaching it
+		const bool reached = (mmc5.irqLine >= 0) ? mmc5.irqLine < mmc5.irqCompare : line == mmc5.irqCompare;
+		if(mmc5.irqCompare && line >= mmc5.irqCompare && reached)
+		{
+			mmc5.irqPending = true;
+		}
+		mmc5.irqLine = line;
+	}
+
+	return mmc5.irqPending && mmc5.irqEnable;
+}
+
+
+void Nes::MMC5SplitUpdate()
+{
+	//the split reads exram as its nametable, which it only is in modes 0 and 1
+	const bool enabled = (mmc5.splitControl & 0x80) && mmc5.exRamMode < 2;
+	ppu.SetVerticalSplit(enabled ? mmc5.exRam.data() : nullptr, mmc5.splitControl, mmc5.splitScroll, mmc5.splitBank);
+}
+
+
+const uint32_t Nes::MMC5NextIrq() const
+{
+	if(!ppu.RenderingEnabled()) //$2001 writes reschedule
+	{
+		return cycleCount + 0x40000000;
+	}
+
+	uint32_t dots = ppu.DotsUntil(240, 0);
+	if(mmc5.irqCompare && mmc5.irqCompare < 240)
+	{
+		dots = std::min(dots, ppu.DotsUntil(mmc5.irqCompare, 1));
+	}
+	return cycleCount + dots / 3;
+}
+
+
+void Nes::VRC4Registers()
+{
+	VrcIrqClock(cycleCount); //bring the irq counter up to date before changing it
+
+	const uint16_t vrc4Address = (addressBus & 0xFF00) | ((addressBus & 0xFF) >> 2);
+	switch(vrc4Address)
+	{
+		case 0x8000: case 0x8001: case 0x8002: case 0x8003:
+			pPrgBank[vrc4.prgMode] = prgRom.data() + ((dataBus & 0b00011111) << 13);
+		break;
+		case 0x9000: case 0x9001:
+			switch(dataBus & 0b11)
+			{
+				case 0: ppu.SetNametableArrangement({A,B,A,B}); break;
+				case 1: ppu.SetNametableArrangement({A,A,B,B}); break;
+				case 2: ppu.SetNametableArrangement({A,A,A,A}); break;
+				case 3: ppu.SetNametableArrangement({B,B,B,B}); break;
+			}
+		break;
+		case 0x9002: case 0x9003:
+			if(vrc4.prgMode != (dataBus & 0b10))
+			{
+				uint8_t *tempBank = pPrgBank[0];
+				pPrgBank[0] = pPrgBank[2];
+				pPrgBank[2] = tempBank;
+			}
+			vrc4.prgMode = dataBus & 0b10;
+		break;
+		case 0xA000: case 0xA001: case 0xA002: case 0xA003:
+			pPrgBank[1] = prgRom.data() + ((dataBus & 0b00011111) << 13);
+		break;
+
+		case 0xB000: case 0xB002: case 0xC000: case 0xC002: case 0xD000: case 0xD002: case 0xE000: case 0xE002:
+		{
+			const uint8_t regSelect = ((vrc4Address >> 11) - 0x16) | ((vrc4Address >> 1) & 1);
+			vrc4.chrSelect[regSelect] = (vrc4.chrSelect[regSelect] & 0x01F0) | (dataBus & 0b1111);
+			ppu.SetPatternBanks1(regSelect, vrc4.chrSelect[regSelect]);
+		}
+		break;
+		case 0xB001: case 0xB003: case 0xC001: case 0xC003: case 0xD001: case 0xD003: case 0xE001: case 0xE003:
+		{
+			const uint8_t regSelect = ((vrc4Address >> 11) - 0x16) | ((vrc4Address >> 1) & 1);
+			vrc4.chrSelect[regSelect] = (vrc4.chrSelect[regSelect] & 0x0F) | ((dataBus & 0b00011111) << 4);
+			ppu.SetPatternBanks1(regSelect, vrc4.chrSelect[regSelect]);
+		}
+		break;
+
+		case 0xF000:
+			vrcIrq.latch &= 0b11110000;
+			vrcIrq.latch |= dataBus & 0b1111;
+		break;
+		case 0xF001:
+			vrcIrq.latch &= 0b1111;
+			vrcIrq.latch |= dataBus << 4;
+		break;
+		case 0xF002: VrcIrqControl();     break;
+		case 0xF003: VrcIrqAcknowledge(); break;
+	}
+}
+
+
+void Nes::VRC6Registers()
+{
+	VrcIrqClock(cycleCount);
+
+	//vrc6b swaps A0 and A1
+	const uint16_t vrc6Address = (type == VRC_6a) ? addressBus & 0xF003 : (addressBus & 0xF000) | ((addressBus & 1) << 1) | ((addressBus >> 1) & 1);
+	switch(vrc6Address)
+	{
+		case 0x8000: case 0x8001: case 0x8002: case 0x8003:
+			pPrgBank[0] = PrgBank8((dataBus & 0b1111) << 1);
+			pPrgBank[1] = pPrgBank[0] + 0x2000;
+		break;
+
+		case 0x9000: case 0x9001: case 0x9002: case 0x9003:
+		case 0xA000: case 0xA001: case 0xA002:
+		case 0xB000: case 0xB001: case 0xB002:
+			apu.expansion.Vrc6Write(vrc6Address, dataBus);
+		break;
+
+		case 0xB003:
+			switch((dataBus >> 2) & 0b11)
+			{
+				case 0: ppu.SetNametableArrangement({A,B,A,B}); break;
+				case 1: ppu.SetNametableArrangement({A,A,B,B}); break;
+				case 2: ppu.SetNametableArrangement({A,A,A,A}); break;
+				case 3: ppu.SetNametableArrangement({B,B,B,B}); break;
+			}
+		break;
+
+		case 0xC000: case 0xC001: case 0xC002: case 0xC003:
+			pPrgBank[2] = PrgBank8(dataBus & 0b00011111);
+		break;
+
+		case 0xD000: case 0xD001: case 0xD002: case 0xD003:
+		case 0xE000: case 0xE001: case 0xE002: case 0xE003:
+			ppu.SetPatternBanks1(((vrc6Address >= 0xE000) << 2) | (vrc6Address & 0b11), dataBus);
+		break;
+
+		case 0xF000: vrcIrq.latch = dataBus;  break;
+		case 0xF001: VrcIrqControl();         break;
+		case 0xF002: VrcIrqAcknowledge();     break;
+	}
+}
+
+
+void Nes::VrcIrqControl()
+{
+	vrcIrq.pending = false;
+	vrcIrq.ackEnable = dataBus & 1;
+	vrcIrq.enable = dataBus & 0b10;
+	vrcIrq.mode = dataBus & 0b0100;
+	if(vrcIrq.enable)
+	{
+		vrcIrq.counter = vrcIrq.latch;
+		vrcIrq.prescalerCounter2 = 341;
+	}
+}
+
+
+void Nes::VrcIrqAcknowledge()
+{
+	vrcIrq.pending = false;
+	vrcIrq.enable = vrcIrq.ackEnable;
+}
+
+
+bool Nes::VrcInterrupt()
+{
+	VrcIrqClock(cycleCount + 1);
+	return vrcIrq.pending;
+}
+
+
+void Nes::VrcIrqClock(const uint32_t cycle) //run the irq counter for all cycles before the given one
+{
+	uint32_t cycles = cycle - vrcIrq.lastCycle;
+	vrcIrq.lastCycle = cycle;
+
+	while(vrcIrq.enable && cycles)
+	{
+		if(vrcIrq.counter == 0xFF)
+		{
+			vrcIrq.pending = true;
+			vrcIrq.counter = vrcIrq.latch;
+			--cycles;
+		}
+		else if(vrcIrq.mode == true)
+		{
+			const uint32_t steps = std::min<uint32_t>(cycles, 0xFF - vrcIrq.counter);
+			vrcIrq.counter += steps;
+			cycles -= steps;
+		}
+		else
+		{
+			//prescaler drops by 3 every cycle and counts when it reaches 0 or below
+			const uint32_t toWrap = (vrcIrq.prescalerCounter2 + 2) / 3;
+			if(cycles < toWrap)
+			{
+				vrcIrq.prescalerCounter2 -= cycles * 3;
+				cycles = 0;
+			}
+			else
+			{
+				vrcIrq.prescalerCounter2 += 341 - toWrap * 3;
+				++vrcIrq.counter;
+				cycles -= toWrap;
+			}
+		}
+	}
+}
+
+
+const uint32_t Nes::VrcIrqNext() const //cycle in which the counter overflows next
+{
+	const uint32_t steps = 0xFF - vrcIrq.counter;
+	if(vrcIrq.mode == true || steps == 0)
+	{
+		return vrcIrq.lastCycle + steps;
+	}
+	return vrcIrq.lastCycle + (vrcIrq.prescalerCounter2 + 341 * (steps - 1) + 2) / 3;
+}
+
+
+void Nes::FME7Registers()
+{
+	FME7Clock(cycleCount);
+
+	switch(addressBus >> 13)
+	{
+		case 0x8000 >> 13:
+			fme7.command = dataBus & 0x0F;
+		break;
+
+		case 0xA000 >> 13:
+			switch(fme7.command)
+			{
+				case 0x0: case 0x1: case 0x2: case 0x3: case 0x4: case 0x5: case 0x6: case 0x7:
+					ppu.SetPatternBanks1(fme7.command, dataBus);
+				break;
+
+				case 0x8: //$6000: rom, or ram that can be disabled
+					if(dataBus & 0b01000000)
+					{
+						prgRamEnable = dataBus & 0x80;
+						prgRamWritable = true;
+						for(int x = 0; x < 4; ++x)
+						{
+							pPrgRamBank[x] = prgRam.data() + x * 0x800;
+						}
+					}
+					else
+					{
+						prgRamEnable = true;
+						prgRamWritable = false;
+						for(int x = 0; x < 4; ++x)
+						{
+							pPrgRamBank[x] = PrgBank8(dataBus & 0b00111111) + x * 0x800;
+						}
+					}
+				break;
+
+				case 0x9: case 0xA: case 0xB:
+					pPrgBank[fme7.command - 9] = PrgBank8(dataBus & 0b00111111);
+				break;
+
+				case 0xC:
+					switch(dataBus & 0b11)
+					{
+						case 0: ppu.SetNametableArrangement({A,B,A,B}); break;
+						case 1: ppu.SetNametableArrangement({A,A,B,B}); break;
+						case 2: ppu.SetNametableArrangement({A,A,A,A}); break;
+						case 3: ppu.SetNametableArrangement({B,B,B,B}); break;
+					}
+				break;
+
+				case 0xD:
+					fme7.irqEnable = dataBus & 1;
+					fme7.irqCounterEnable = dataBus & 0x80;
+					fme7.irqPending = false;
+				break;
+
+				case 0xE: fme7.irqCounter = (fme7.irqCounter & 0xFF00) | dataBus;        break;
+				case 0xF: fme7.irqCounter = (fme7.irqCounter & 0x00FF) | (dataBus << 8); break;
+			}
+		break;
+
+		case 0xC000 >> 13: apu.expansion.Sunsoft5BSelect(dataBus); break;
+		case 0xE000 >> 13: apu.expansion.Sunsoft5BWrite(dataBus);  break;
+	}
+}
+
+
+bool Nes::FME7Interrupt()
+{
+	FME7Clock(cycleCount + 1);
+	return fme7.irqPending;
+}
+
+
+void Nes::FME7Clock(const uint32_t cycle) //the counter decrements every cycle and fires when it wraps
+{
+	const uint32_t cycles = cycle - fme7.lastCycle;
+	fme7.lastCycle = cycle;
+
+	if(fme7.irqCounterEnable)
+	{
+		if(cycles > fme7.irqCounter)
+		{
+			fme7.irqPending |= fme7.irqEnable;
+		}
+		fme7.irqCounter -= cycles;
+	}
+}
+
+
+void Nes::N163Registers()
+{
+	switch(addressBus >> 11)
+	{
+		case 0x4800 >> 11: apu.expansion.N163DataWrite(dataBus); break;
+
+		case 0x5000 >> 11:
+			N163Clock(cycleCount);
+			n163.irqCounter = (n163.irqCounter & 0xFF00) | dataBus;
+		break;
+
+		case 0x5800 >> 11:
+			N163Clock(cycleCount);
+			n163.irqCounter = (n163.irqCounter & 0x00FF) | (dataBus << 8);
+		break;
+
+		case 0x8000 >> 11: case 0x8800 >> 11: case 0x9000 >> 11: case 0x9800 >> 11:
+		case 0xA000 >> 11: case 0xA800 >> 11: case 0xB000 >> 11: case 0xB800 >> 11:
+		case 0xC000 >> 11: case 0xC800 >> 11: case 0xD000 >> 11: case 0xD800 >> 11:
+		{
+			const uint8_t reg = (addressBus - 0x8000) >> 11;
+			n163.chr[reg] = dataBus;
+			N163ChrUpdate(reg);
+		}
+		break;
+
+		case 0xE000 >> 11:
+			pPrgBank[0] = PrgBank8(dataBus & 0b00111111);
+			apu.expansion.N163Enable(!(dataBus & 0b01000000));
+		break;
+
+		case 0xE800 >> 11:
+			pPrgBank[1] = PrgBank8(dataBus & 0b00111111);
+			n163.chrRamDisable = dataBus >> 6;
+			for(uint8_t x = 0; x < 8; ++x)
+			{
+				N163ChrUpdate(x);
+			}
+		break;
+
+		case 0xF000 >> 11: pPrgBank[2] = PrgBank8(dataBus & 0b00111111); break;
+		case 0xF800 >> 11: apu.expansion.N163AddressWrite(dataBus);      break;
+	}
+}
+
+
+void Nes::N163Read()
+{
+	switch(addressBus >> 11)
+	{
+		case 0x4800 >> 11: dataBus = apu.expansion.N163DataRead(); break;
+
+		case 0x5000 >> 11:
+			N163Clock(cycleCount);
+			dataBus = n163.irqCounter;
+		break;
+
+		case 0x5800 >> 11:
+			N163Clock(cycleCount);
+			dataBus = n163.irqCounter >> 8;
+		break;
+	}
+}
+
+
+void Nes::N163ChrUpdate(const uint8_t reg)
+{
+	const uint8_t bank = n163.chr[reg];
+	if(reg < 8) //$E0 and up select ciram instead of chr rom, unless disabled for that pattern table
+	{
+		if(bank >= 0xE0 && !((n163.chrRamDisable >> (reg >> 2)) & 1))
+		{
+			ppu.SetPatternNametable(reg, (bank & 1) ? B : A);
+		}
+		else
+		{
+			ppu.SetPatternBanks1(reg, bank);
+		}
+	}
+	else //nametables can come from chr rom as well
+	{
+		if(bank >= 0xE0)
+		{
+			ppu.SetNametable(reg - 8, (bank & 1) ? B : A);
+		}
+		else
+		{
+			ppu.SetNametableChr(reg - 8, bank);
+		}
+	}
+}
+
+
+bool Nes::N163Interrupt()
+{
+	N163Clock(cycleCount + 1);
+	return n163.irqCounter == 0xFFFF;
+}
+
+
+void Nes::N163Clock(const uint32_t cycle) //counts up every cycle while enabled and stops at $7FFF
+{
+	const uint32_t cycles = cycle - n163.lastCycle;
+	n163.lastCycle = cycle;
+
+	if(n163.irqCounter & 0x8000)
+	{
+		n163.irqCounter = 0x8000 | std::min<uint32_t>(0x7FFF, (n163.irqCounter & 0x7FFF) + cycles);
+	}
+}
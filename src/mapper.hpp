@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+
+struct VrcIrq //shared by vrc4 and vrc6
+{
+	uint32_t lastCycle = 0;
+	int16_t prescalerCounter2 = 341;
+	uint8_t latch = 0;
+	uint8_t counter = 0;
+	bool pending = false;
+	bool enable = false;
+	bool ackEnable = false;
+	bool mode = false;
+};
+
+struct VRC4
+{
+	std::array<uint16_t, 8> chrSelect{};
+	uint8_t prgMode = 0;
+};
+
+struct MMC1
+{
+	uint32_t lastWrittenTo = 0;
+	uint8_t shiftReg = 0b100000;
+	uint8_t prgMode = 0b11;
+	uint8_t prg = 0;
+	bool wramEnable = 0;
+	bool chrMode = 0;
+	uint8_t chr0 = 0;
+	uint8_t chr1 = 0;
+};
+
+struct MMC3
+{
+	std::array<uint8_t, 8> bankReg{};
+	uint8_t bankRegSelect = 0, irqLatch = 0, irqCounter = 0;
+	bool prgMode = 0, chrMode = 0, irqEnable = 0, irqPending = 0, irqReload = 0;
+	std::array<bool, 3> A12{};
+};
+
+struct MMC5
+{
+	std::array<uint8_t, 0x400> exRam{};
+	std::array<uint8_t, 0x400> fill{};           //fill mode nametable
+	std::array<uint8_t, 5> prg{{0, 0xFF, 0xFF, 0xFF, 0xFF}}; //5113-5117
+	std::array<uint16_t, 12> chr{};              //5120-512B, upper bits from 5130 at write time
+	std::array<bool, 4> prgWindowRam{};
+	uint8_t prgMode = 3, chrMode = 0, exRamMode = 0, chrHigh = 0;
+	uint8_t ramProtect1 = 0, ramProtect2 = 0;
+	uint8_t irqCompare = 0;
+	uint8_t splitControl = 0, splitScroll = 0, splitBank = 0; //5200-5202
+	uint8_t multiplicand = 0xFF, multiplier = 0xFF;
+	int16_t irqLine = -1;                        //scanline of the last irq check, -1 = not in frame
+	bool irqEnable = false, irqPending = false;
+	bool sprite8x16 = false, chrSetB = false;
+};
+
+struct FME7
+{
+	uint32_t lastCycle = 0;
+	uint16_t irqCounter = 0;
+	uint8_t command = 0;
+	bool irqEnable = false, irqCounterEnable = false, irqPending = false;
+};
+
+struct N163
+{
+	uint32_t lastCycle = 0;
+	uint16_t irqCounter = 0; //bit 15 = enable
+	std::array<uint8_t, 12> chr{};
+	uint8_t chrRamDisable = 0;
+};
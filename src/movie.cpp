@@ -0,0 +1,207 @@
+#include <iostream>
+
+#include "movie.hpp"
+#include "file.hpp"
+
+
+Movie::~Movie()
+{
+	Stop();
+}
+
+
+bool Movie::Record(const std::string &path, Nes &nes, const MovieAnchor anchor, const uint8_t hashInterval)
+{
+	Stop();
+	if(!PadsOnly(nes))
+	{
+		std::cout << "Movies only record pads, " << path << " needs pads in both ports" << std::endl;
+		return false;
+	}
+
+	header = MovieHeader();
+	header.romSha1 = nes.GetRomSha1();
+	header.anchor = anchor;
+	header.hashInterval = hashInterval;
+	header.prgRamHash = nes.PrgRamHash();
+	stateBuffer.clear();
+	if(anchor == SaveStateAnchor)
+	{
+		nes.SaveState(stateBuffer);
+	}
+	header.stateSize = stateBuffer.size();
+
+	output.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!output.is_open())
+	{
+		std::cout << "Could not create " << path << std::endl;
+		return false;
+	}
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(stateBuffer.data()), stateBuffer.size());
+
+	mode = MovieRecord;
+	frame = 0;
+	desyncFrame = -1;
+	return true;
+}
+
+
+bool Movie::Play(const std::string &path, Nes &nes)
+{
+	Stop();
+
+	data = FileToU8Vec(path);
+	if(data.size() < sizeof(header))
+	{
+		std::cout << path << " is not a movie" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	if(header.magic != MovieHeader().magic || header.version != MovieHeader().version)
+	{
+		std::cout << path << " is not a movie or from an incompatible version" << std::endl;
+		return false;
+	}
+	if(header.romSha1 != nes.GetRomSha1())
+	{
+		std::cout << path << " was recorded with a different rom" << std::endl;
+		return false;
+	}
+	if(!PadsOnly(nes))
+	{
+		std::cout << path << " was recorded with pads, it needs pads in both ports" << std::endl;
+		return false;
+	}
+	if(data.size() < sizeof(header) + header.stateSize)
+	{
+		std::cout << path << " is truncated" << std::endl;
+		return false;
+	}
+	if(nes.BatteryMapped()) //the anchor state and the replayed game would overwrite the player's saves
+	{
+		std::cout << path << " has to be played with a copy of the battery ram, not the .sav itself" << std::endl;
+		return false;
+	}
+
+	position = sizeof(header);
+	if(header.anchor == SaveStateAnchor)
+	{
+		stateBuffer.assign(data.begin() + position, data.begin() + position + header.stateSize);
+		if(!nes.LoadState(stateBuffer))
+		{
+			std::cout << path << " has a broken save state" << std::endl;
+			return false;
+		}
+	}
+	else if(header.prgRamHash != nes.PrgRamHash())
+	{
+		std::cout << "Battery ram differs from when " << path << " was recorded, it may desync" << std::endl;
+	}
+	position += header.stateSize;
+
+	mode = MoviePlay;
+	frame = 0;
+	desyncFrame = -1;
+	return true;
+}
+
+
+void Movie::Stop()
+{
+	if(output.is_open())
+	{
+		output.close();
+	}
+	data.clear();
+	mode = MovieOff;
+}
+
+
+void Movie::AdvanceFrame(Nes &nes, InputFrame input, const uint8_t skip)
+{
+	if(mode != MovieOff && !PadsOnly(nes)) //a device plugged in mid movie
+	{
+		std::cout << "Movie stopped at frame " << frame << ", only pads are recorded" << std::endl;
+		Stop();
+	}
+
+	const bool hashFrame = header.hashInterval && (frame + 1) % header.hashInterval == 0;
+
+	if(mode == MoviePlay)
+	{
+		const size_t frameSize = 2 + (hashFrame ? 4 : 0);
+		if(position + frameSize > data.size()) //end of movie, hand control back
+		{
+			Stop();
+		}
+		else
+		{
+			input.pads[0] = data[position];
+			input.pads[1] = data[position + 1];
+			nes.AdvanceFrame(input, skip | SkipInputPoll);
+
+			if(hashFrame)
+			{
+				uint32_t hash;
+				std::memcpy(&hash, &data[position + 2], 4);
+				if(desyncFrame == -1 && hash != CurrentHash(nes))
+				{
+					desyncFrame = frame;
+				}
+			}
+			position += frameSize;
+			++frame;
+			if(position == data.size())
+			{
+				Stop();
+			}
+			return;
+		}
+	}
+
+	nes.AdvanceFrame(input, skip);
+
+	if(mode == MovieRecord)
+	{
+		output.put(nes.GetInput().pads[0]); //what the frame ran with, after any late poll
+		output.put(nes.GetInput().pads[1]);
+		if(hashFrame)
+		{
+			const uint32_t hash = CurrentHash(nes);
+			output.write(reinterpret_cast<const char*>(&hash), 4);
+		}
+		++frame;
+	}
+}
+
+
+const MovieMode Movie::GetMode() const
+{
+	return mode;
+}
+
+
+const uint32_t Movie::GetFrame() const
+{
+	return frame;
+}
+
+
+const int64_t Movie::GetDesyncFrame() const
+{
+	return desyncFrame;
+}
+
+
+const bool Movie::PadsOnly(const Nes &nes)
+{
+	return nes.GetInputDevice(0) == DevicePad && nes.GetInputDevice(1) == DevicePad;
+}
+
+
+const uint32_t Movie::CurrentHash(Nes &nes)
+{
+	nes.SaveState(stateBuffer);
+	return StateHash(stateBuffer.data(), stateBuffer.size());
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "nes.hpp"
+
+
+enum MovieMode : uint8_t {MovieOff = 0, MovieRecord = 1, MoviePlay = 2};
+enum MovieAnchor : uint8_t {PowerOn = 0, SaveStateAnchor = 1};
+
+//header: "FMV" 1A | version | rom sha1 | anchor | hash interval | prg ram hash | state size | state
+//then per frame: pad 1, pad 2, and a state hash after every hashInterval frames. no other device is recorded
+struct MovieHeader
+{
+	std::array<char, 4> magic{{'F', 'M', 'V', 0x1A}};
+	uint32_t version = 1;
+	std::array<uint32_t, 5> romSha1{};
+	MovieAnchor anchor = PowerOn;
+	uint8_t hashInterval = 1; //0 = no desync check
+	uint16_t reserved = 0;
+	uint32_t prgRamHash = 0;  //battery ram at power on, replays only match if it's the same
+	uint32_t stateSize = 0;
+};
+
+
+class Movie
+{
+	public:
+		~Movie();
+
+		//power on movies have to be started on a freshly constructed Nes. both ends want one made with BatteryCopy, playback refuses a mapped .sav.
+		//both refuse anything but pads in the ports, plugging in another device stops the movie
+		bool Record(const std::string &path, Nes &nes, const MovieAnchor anchor, const uint8_t hashInterval = 1);
+		bool Play(const std::string &path, Nes &nes);
+		void Stop();
+
+		void AdvanceFrame(Nes &nes, InputFrame input, const uint8_t skip = SkipNone); //replaces pads 1 and 2 while playing
+
+		const MovieMode GetMode() const;
+		const uint32_t GetFrame() const;
+		const int64_t GetDesyncFrame() const; //first frame whose state hash didn't match, -1 if none
+
+	private:
+		static const bool PadsOnly(const Nes &nes); //zapper aim, the arkanoid knob and pads 3 and 4 aren't recorded
+		const uint32_t CurrentHash(Nes &nes);
+
+		MovieMode mode = MovieOff;
+		MovieHeader header;
+		std::ofstream output;
+		std::vector<uint8_t> data;
+		size_t position = 0;
+		uint32_t frame = 0;
+		int64_t desyncFrame = -1;
+		std::vector<uint8_t> stateBuffer;
+};
@@ -1,59 +1,220 @@
-// #define DEBUG
 // #define DUMP_VRAM
 
 #include <fstream>
 #include <iostream>
-#include <iomanip>
 
 #include "nes.hpp"
 #include "apu.hpp"
 #include "ppu.hpp"
 
 
-Nes::Nes(std::string inFile)
+Nes::Nes(std::string inFile, const BatteryMode battery)
 {
-	Cart cart(inFile, prgRom, prgRam);
+	ClearPadding(irqScheduler);
+	ClearPadding(vrc4);
+	ClearPadding(vrcIrq);
+	ClearPadding(mmc1);
+	ClearPadding(mmc3);
+	ClearPadding(mmc5);
+	ClearPadding(fme7);
+	ClearPadding(n163);
+
+	Cart cart(inFile, prgRom, prgRam, battery);
+	if(!cart.loaded)
+	{
+		return;
+	}
+	loaded = true;
 	type = cart.type;
+	romSha1 = cart.sha1;
 	pPrgBank = cart.pPrgBank;
 	pPrgRamBank = cart.pPrgRamBank;
 	ppu.SetPattern(cart.chrMem);
 	ppu.SetNametableArrangement(cart.nametableOffsets);
 	ppu.SetChrType(cart.chrType);
+	MapperInit();
 
 	Reset();
+
+	std::vector<uint8_t> state;
+	SaveState(state);
+	stateSize = state.size();
 }
 
 
-void Nes::AdvanceFrame(uint8_t input, uint8_t input2)
+void Nes::AdvanceFrame(const uint8_t input, const uint8_t input2, const uint8_t skip)
 {
-	while(!ppu.renderFrame)
+	InputFrame frame;
+	frame.pads[0] = input;
+	frame.pads[1] = input2;
+	AdvanceFrame(frame, skip);
+}
+
+
+void Nes::AdvanceFrame(const InputFrame &input, const uint8_t skip)
+{
+	ports.SetFrame(input, !(skip & SkipInputPoll));
+	//a zapper looks at the pixels as they're drawn, so frames are rendered for it even if nobody sees them
+	ppu.skipRender = (skip & SkipVideo) && ports.Device(0) != DeviceZapper && ports.Device(1) != DeviceZapper;
+	apu.skipAudio = skip & SkipAudio;
+
+	if((debugger || codeLogger || profiler) ? !RunFrame<true>() : !RunFrame<false>()) //stopped frames go on where they left off
 	{
-		RunOpcode();
+		return;
+	}
+	ppu.renderFrame = false;
 
-		if(readJoy1)
+	if(profiler)
+	{
+		profiler->EndFrame();
+	}
+	if(eventLog)
+	{
+		eventLog->EndFrame();
+	}
+
+	if(++saveSyncFrames == 600) //battery ram is already in the page cache, this just bounds what an os crash can lose
+	{
+		prgRam.Sync(false);
+		saveSyncFrames = 0;
+	}
+}
+
+
+template<bool Debug>
+bool Nes::RunFrame()
+{
+	while(!ppu.renderFrame)
+	{
+		if(Debug && debugger && debugger->Stopped())
 		{
-			controller_reg = input;
-			controller_reg2 = input2;
+			return false;
 		}
+
+		RunOpcode<Debug>();
 	}
-	ppu.renderFrame = false;
+	return !(Debug && debugger && debugger->Stopped()); //a stop in the last instruction ends the frame on the next call
+}
+
 
-	if(input2 & 0b10) //H key, temp
+void Nes::RunAhead(const uint8_t frames)
+{
+	if(!frames || debugger || trace || codeLogger || profiler || eventLog) //attached tools would see frames that get rolled back
 	{
-		Reset();
+		return;
 	}
+
+	//games react to input a frame or more late, so emulate past that lag with the input held
+	//only the last speculative frame is drawn and none are heard, the real frame's samples stay in the buffer
+	const InputFrame held = ports.Frame();
+	SaveState(runAheadState);
+	for(uint8_t x = 0; x < frames; ++x)
+	{
+		AdvanceFrame(held, (x + 1 < frames) ? SkipVideo | SkipAudio | SkipInputPoll : SkipAudio | SkipInputPoll);
+	}
+	apu.skipAudio = false;
+	LoadState(runAheadState);
+}
+
+
+void Nes::SetTrace(Trace *newTrace)
+{
+	trace = newTrace;
+}
+
+
+void Nes::SetDebugger(Debugger *newDebugger)
+{
+	debugger = newDebugger;
+}
+
+
+void Nes::SetCodeLogger(CodeLogger *newLogger)
+{
+	codeLogger = newLogger;
+	if(codeLogger)
+	{
+		codeLogger->Resize(prgRom.size(), ppu.ChrRomSize());
+	}
+}
+
+
+void Nes::SetProfiler(Profiler *newProfiler)
+{
+	profiler = newProfiler;
+	if(profiler)
+	{
+		profiler->Resize(prgRom.size());
+		profiler->Start(cycleCount);
+	}
+}
+
+
+void Nes::SetInputDevice(const uint8_t port, const InputDevice device)
+{
+	ports.Connect(port, device);
+}
+
+
+const InputDevice Nes::GetInputDevice(const uint8_t port) const
+{
+	return ports.Device(port);
+}
+
+
+void Nes::SetInputPoll(std::function<void(InputFrame&)> poll)
+{
+	ports.SetPoll(poll);
+}
+
+
+const InputFrame& Nes::GetInput() const
+{
+	return ports.Frame();
+}
+
+
+void Nes::SetEventLog(EventLog *newLog)
+{
+	eventLog = newLog;
+}
+
+
+void Nes::LogEvent(const PpuEventType type, const uint16_t address, const uint8_t value)
+{
+	eventLog->Record({ppu.GetScanlineV(), ppu.GetScanlineH(), address, value, type});
+}
+
+
+const bool Nes::Loaded() const
+{
+	return loaded;
+}
+
+
+const bool Nes::Jammed() const
+{
+	return jammed;
 }
 
 
 const NesInfo Nes::GetInfo() const
 {
-	return {rA, rX, rY, rS};
+	return {rA, rX, rY, rS, cycleCount};
+}
+
+
+const std::array<uint32_t, 5> Nes::GetRomSha1() const
+{
+	return romSha1;
 }
 
 
 void Nes::Reset()
 {
+	jammed = false;
 	apu.Reset();
+	ScheduleIrq(FrameCounterIrq, cycleCount);
 
 	CpuRead(PC); //PC?
 	CpuRead(PC);
@@ -72,14 +233,42 @@ void Nes::Reset()
 }
 
 
+template<bool Debug>
 void Nes::RunOpcode()
 {
 	const uint8_t opcode = dataBus;
 
+	if(Debug)
+	{
+		instructionPC = PC;
+		if(debugger)
+		{
+			debugger->Exec({PC, PC, rA, rX, rY, rS, uint8_t(rP.to_ulong()), opcode, ppu.GetScanlineV(), ppu.GetScanlineH(), cycleCount});
+			if(debugger->Stopped()) //the opcode is fetched, it runs once resumed
+			{
+				return;
+			}
+		}
+		if(codeLogger)
+		{
+			for(uint8_t x = 0; x < CodeLogger::InstructionLength(opcode); ++x)
+			{
+				LogPrg(PC + x, CdlCode, AccessExec);
+			}
+		}
+		if(profiler)
+		{
+			const bool call = (opcode == 0x20 || opcode == 0x00); //jsr, brk
+			const uint16_t target = (opcode == 0x20) ? DebugRead(PC + 1) | DebugRead(PC + 2) << 8 : DebugRead(0xFFFE) | DebugRead(0xFFFF) << 8;
+			const ProfileOp op = call ? ProfileCall : (opcode == 0x60 || opcode == 0x40) ? ProfileReturn : ProfileNone; //rts, rti
+			profiler->Instruction(ProfileLocation(PC), PC, cycleCount, rS, op, call ? ProfileLocation(target) : 0);
+		}
+	}
 
-	#ifdef DEBUG
-		DebugCpu(opcode);
-	#endif
+	if(trace && trace->Wants(PC, ppu.GetScanlineV()))
+	{
+		trace->Record({cycleCount, PC, opcode, DebugRead(PC + 1), DebugRead(PC + 2), rA, rX, rY, uint8_t(rP.to_ulong()), rS, ppu.GetScanlineH(), ppu.GetScanlineV()});
+	}
 	#ifdef DUMP_VRAM
 		if(ppu.GetScanlineV() == 261 && ppu.GetScanlineH() == 0)
 		{
@@ -91,7 +280,7 @@ void Nes::RunOpcode()
 	#endif
 
 
-	CpuRead(++PC); //fetch op1
+	CpuRead<Debug>(++PC); //fetch op1
 
 	const uint8_t op1 = dataBus;
 
@@ -110,16 +299,16 @@ void Nes::RunOpcode()
 
 		case 0x00: //BRK
 			++PC;
-			CpuWrite(0x0100 | rS--, PC >> 8);
-			CpuWrite(0x0100 | rS--, PC);
-			CpuWrite(0x0100 | rS--, rP.to_ulong() | 0b00010000);
+			CpuWrite<Debug>(0x0100 | rS--, PC >> 8);
+			CpuWrite<Debug>(0x0100 | rS--, PC);
+			CpuWrite<Debug>(0x0100 | rS--, rP.to_ulong() | 0b00010000);
 		{
 			const uint16_t interruptVector = 0xFFFE ^ (nmiPending[1] << 2); //possible NMI hijack
 			nmiPending[0] &= !nmiPending[1]; //haven't tested, but should be correct
-			CpuRead(interruptVector);
+			CpuRead<Debug>(interruptVector);
 			tempData = dataBus;
 			rP.set(2);
-			CpuRead(interruptVector + 1);
+			CpuRead<Debug>(interruptVector + 1);
 		}
 			nmiPending[1] = false; //NMI delayed until after next instruction
 			PC = tempData | (dataBus << 8);
@@ -127,24 +316,25 @@ void Nes::RunOpcode()
 
 		case 0x02: case 0x12: case 0x22: case 0x32: case 0x42: case 0x52: //KIL
 		case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:
-			std::cout << "CRASH" << std::endl;
-			exit(0);
+			//the cpu stops fetching and ignores interrupts. fetching the KIL again keeps the rest of the console running
+			jammed = true;
+			CpuRead<Debug>(--PC);
 		break;
 
 		case 0x08: //PHP
-			CpuWrite(0x0100 | rS--, rP.to_ulong() | 0b00010000);
+			CpuWrite<Debug>(0x0100 | rS--, rP.to_ulong() | 0b00010000);
 		break;
 		case 0x28: //PLP
-			CpuRead(0x0100 | rS++);
-			CpuRead(0x0100 | rS);
+			CpuRead<Debug>(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS);
 			rP = dataBus | 0x20;
 		break;
 		case 0x48: //PHA
-			CpuWrite(0x0100 | rS--, rA);
+			CpuWrite<Debug>(0x0100 | rS--, rA);
 		break;
 		case 0x68: //PLA
-			CpuRead(0x0100 | rS++);
-			CpuRead(0x0100 | rS);
+			CpuRead<Debug>(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS);
 
 			rA = dataBus;
 			rP[1] = !rA;
@@ -182,14 +372,14 @@ void Nes::RunOpcode()
 			rP[7] = rA & 0x80;
 		break;
 
-		case 0x10: Branch(!rP[7], op1); break; //BPL
-		case 0x30: Branch( rP[7], op1); break; //BMI
-		case 0x50: Branch(!rP[6], op1); break; //BVC
-		case 0x70: Branch( rP[6], op1); break; //BVS
-		case 0x90: Branch(!rP[0], op1); break; //BCC
-		case 0xB0: Branch( rP[0], op1); break; //BCS
-		case 0xD0: Branch(!rP[1], op1); break; //BNE
-		case 0xF0: Branch( rP[1], op1); break; //BEQ
+		case 0x10: Branch<Debug>(!rP[7], op1); break; //BPL
+		case 0x30: Branch<Debug>( rP[7], op1); break; //BMI
+		case 0x50: Branch<Debug>(!rP[6], op1); break; //BVC
+		case 0x70: Branch<Debug>( rP[6], op1); break; //BVS
+		case 0x90: Branch<Debug>(!rP[0], op1); break; //BCC
+		case 0xB0: Branch<Debug>( rP[0], op1); break; //BCS
+		case 0xD0: Branch<Debug>(!rP[1], op1); break; //BNE
+		case 0xF0: Branch<Debug>( rP[1], op1); break; //BEQ
 
 		case 0x18: rP.reset(0); break; //CLC
 		case 0x38: rP.set(0);   break; //SEC
@@ -202,49 +392,49 @@ void Nes::RunOpcode()
 		case 0x20: //JSR
 			++PC;
 			// rS = op1; //wtf
-			CpuRead(0x0100 | rS--);
-			CpuWrite(addressBus, PC >> 8);
-			CpuWrite(0x0100 | rS--, PC);
-			CpuRead(PC);
+			CpuRead<Debug>(0x0100 | rS--);
+			CpuWrite<Debug>(addressBus, PC >> 8);
+			CpuWrite<Debug>(0x0100 | rS--, PC);
+			CpuRead<Debug>(PC);
 
 			PC = op1 + (dataBus << 8);
 			break;
 		case 0x40: //RTI
 			++PC;
-			CpuRead(0x0100 | rS++);
-			CpuRead(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS++);
 
 			rP = dataBus | 0x20;
-			CpuRead(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS++);
 			tempData = dataBus;
 
-			CpuRead(0x0100 | rS);
+			CpuRead<Debug>(0x0100 | rS);
 
 			PC = tempData | (dataBus << 8);
 			break;
 		case 0x60: //RTS
 			++PC;
-			CpuRead(0x0100 | rS++);
-			CpuRead(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS++);
+			CpuRead<Debug>(0x0100 | rS++);
 			tempData = dataBus;
 
-			CpuRead(0x0100 | rS);
+			CpuRead<Debug>(0x0100 | rS);
 
 			PC = tempData | (dataBus << 8);
-			CpuRead(PC++);
+			CpuRead<Debug>(PC++);
 			break;
 
 		case 0x4C: //JMP abs
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			PC = op1 | (dataBus << 8);
 			break;
 		case 0x6C: //JMP ind
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 
 			++PC;
-			CpuRead(op1 | (dataBus << 8));
+			CpuRead<Debug>(op1 | (dataBus << 8));
 			tempData = dataBus;
-			CpuRead((addressBus & 0xFF00) + uint8_t(addressBus + 1));
+			CpuRead<Debug>((addressBus & 0xFF00) + uint8_t(addressBus + 1));
 
 			PC = tempData | (dataBus << 8);
 		break;
@@ -272,98 +462,98 @@ void Nes::RunOpcode()
 
 		case 0x81: //STA (ind,x) indexed indirect
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(addressBus + rX));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(addressBus + rX));
 			tempData = dataBus;
-			CpuRead(uint8_t(addressBus + 1));
-			CpuWrite(tempData | (dataBus << 8), rA);
+			CpuRead<Debug>(uint8_t(addressBus + 1));
+			CpuWrite<Debug>(tempData | (dataBus << 8), rA);
 			break;
 		case 0x85: //STA zp
 			++PC;
-			CpuWrite(op1, rA);
+			CpuWrite<Debug>(op1, rA);
 			break;
 		case 0x8D: //STA abs
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuWrite(op1 | (dataBus << 8), rA);
+			CpuWrite<Debug>(op1 | (dataBus << 8), rA);
 			break;
 		case 0x91: //STA (ind),y indirect indexed
 			++PC;
-			CpuRead(op1);
+			CpuRead<Debug>(op1);
 			tempData = dataBus;
-			CpuRead(uint8_t(op1 + 1));
-			CpuRead(uint8_t(tempData + rY) | (dataBus << 8));
-			CpuWrite(addressBus + (tempData + rY & 0x0100), rA);
+			CpuRead<Debug>(uint8_t(op1 + 1));
+			CpuRead<Debug>(uint8_t(tempData + rY) | (dataBus << 8));
+			CpuWrite<Debug>(addressBus + (tempData + rY & 0x0100), rA);
 			break;
 		case 0x95: //STA zp,x
 			++PC;
-			CpuRead(op1);
-			CpuWrite(uint8_t(addressBus + rX), rA);
+			CpuRead<Debug>(op1);
+			CpuWrite<Debug>(uint8_t(addressBus + rX), rA);
 			break;
 		case 0x99: //STA abs,y
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuRead(uint8_t(op1 + rY) | (dataBus << 8));
-			CpuWrite(addressBus + (op1 + rY & 0x0100), rA);
+			CpuRead<Debug>(uint8_t(op1 + rY) | (dataBus << 8));
+			CpuWrite<Debug>(addressBus + (op1 + rY & 0x0100), rA);
 			break;
 		case 0x9D: //STA abs,x
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuRead(uint8_t(op1 + rX) | (dataBus << 8));
-			CpuWrite(addressBus + (op1 + rX & 0x0100), rA);
+			CpuRead<Debug>(uint8_t(op1 + rX) | (dataBus << 8));
+			CpuWrite<Debug>(addressBus + (op1 + rX & 0x0100), rA);
 		break;
 
 		case 0x84: //STY zp
 			++PC;
-			CpuWrite(op1, rY);
+			CpuWrite<Debug>(op1, rY);
 			break;
 		case 0x8C: //STY abs
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuWrite(op1 | (dataBus << 8), rY);
+			CpuWrite<Debug>(op1 | (dataBus << 8), rY);
 			break;
 		case 0x94: //STY zp,x
 			++PC;
-			CpuRead(op1);
-			CpuWrite(uint8_t(addressBus + rX), rY);
+			CpuRead<Debug>(op1);
+			CpuWrite<Debug>(uint8_t(addressBus + rX), rY);
 		break;
 
 		case 0x86: //STX zp
 			++PC;
-			CpuWrite(op1, rX);
+			CpuWrite<Debug>(op1, rX);
 			break;
 		case 0x8E: //STX abs
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuWrite(op1 | (dataBus << 8), rX);
+			CpuWrite<Debug>(op1 | (dataBus << 8), rX);
 			break;
 		case 0x96: //STX zp,y
 			++PC;
-			CpuRead(op1);
-			CpuWrite(uint8_t(addressBus + rY), rX);
+			CpuRead<Debug>(op1);
+			CpuWrite<Debug>(uint8_t(addressBus + rY), rX);
 		break;
 
 		case 0x83: //SAX (ind,x)
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(addressBus + rX));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(addressBus + rX));
 			tempData = dataBus;
-			CpuRead(uint8_t(addressBus + 1));
-			CpuWrite(tempData | (dataBus << 8), rA & rX);
+			CpuRead<Debug>(uint8_t(addressBus + 1));
+			CpuWrite<Debug>(tempData | (dataBus << 8), rA & rX);
 			break;
 		case 0x87: //SAX zp
 			++PC;
-			CpuWrite(op1, rA & rX);
+			CpuWrite<Debug>(op1, rA & rX);
 			break;
 		case 0x8F: //SAX abs
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuWrite(op1 | (dataBus << 8), rA & rX);
+			CpuWrite<Debug>(op1 | (dataBus << 8), rA & rX);
 			break;
 		case 0x97: //SAX zp,y
 			++PC;
-			CpuRead(op1);
-			CpuWrite(uint8_t(addressBus + rY), rA & rX);
+			CpuRead<Debug>(op1);
+			CpuWrite<Debug>(uint8_t(addressBus + rY), rA & rX);
 		break;
 
 		case 0x8A: //TXA
@@ -420,80 +610,80 @@ void Nes::RunOpcode()
 		case 0x06: case 0x07: case 0x26: case 0x27: case 0x46: case 0x47: //z RW
 		case 0x66: case 0x67: case 0xC6: case 0xC7: case 0xE6: case 0xE7:
 			++PC;
-			CpuRead(op1);
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(op1);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x0E: case 0x0F: case 0x2E: case 0x2F: case 0x4E: case 0x4F: //abs RW
 		case 0x6E: case 0x6F: case 0xCE: case 0xCF: case 0xEE: case 0xEF:
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 
 			++PC;
-			CpuRead(op1 | (dataBus << 8));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(op1 | (dataBus << 8));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x16: case 0x17: case 0x36: case 0x37: case 0x56: case 0x57: //z,x RW
 		case 0x76: case 0x77: case 0xD6: case 0xD7: case 0xF6: case 0xF7:
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(op1 + rX));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(op1 + rX));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x1E: case 0x1F: case 0x3E: case 0x3F: case 0x5E: case 0x5F: //abs,x RW
 		case 0x7E: case 0x7F: case 0xDE: case 0xDF: case 0xFE: case 0xFF:
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			tempData = dataBus;
 			++PC;
-			CpuRead(uint8_t(op1 + rX) | (tempData << 8));
-			CpuRead(op1 + rX + (tempData << 8));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(uint8_t(op1 + rX) | (tempData << 8));
+			CpuRead<Debug>(op1 + rX + (tempData << 8));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x1B: case 0x3B: case 0x5B: case 0x7B: case 0xDB: case 0xFB: //abs,y RW
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			tempData = dataBus;
 			++PC;
-			CpuRead(uint8_t(op1 + rY) | (tempData << 8));
-			CpuRead(op1 + rY + (tempData << 8));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(uint8_t(op1 + rY) | (tempData << 8));
+			CpuRead<Debug>(op1 + rY + (tempData << 8));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x03: case 0x23: case 0x43: case 0x63: case 0xC3: case 0xE3: //(indir,x) RW
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(addressBus + rX));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(addressBus + rX));
 			tempData = dataBus;
-			CpuRead(uint8_t(addressBus + 1));
-			CpuRead(tempData | (dataBus << 8));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(uint8_t(addressBus + 1));
+			CpuRead<Debug>(tempData | (dataBus << 8));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x13: case 0x33: case 0x53: case 0x73: case 0xD3: case 0xF3: //(ind),y RW
 			++PC;
-			CpuRead(op1);
+			CpuRead<Debug>(op1);
 			tempData = dataBus;
-			CpuRead(uint8_t(op1 + 1));
-			CpuRead(uint8_t(tempData + rY) | (dataBus << 8));
-			CpuRead(addressBus + (tempData + rY & 0x0100));
-			CpuWrite(addressBus, dataBus);
+			CpuRead<Debug>(uint8_t(op1 + 1));
+			CpuRead<Debug>(uint8_t(tempData + rY) | (dataBus << 8));
+			CpuRead<Debug>(addressBus + (tempData + rY & 0x0100));
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x01: case 0x21: case 0x41: case 0x61: //(indirect,x) / indexed indirect R
 		case 0xA1: case 0xA3: case 0xC1: case 0xE1:
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(addressBus + rX));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(addressBus + rX));
 			tempData = dataBus;
-			CpuRead(uint8_t(addressBus + 1));
-			CpuRead(tempData | (dataBus << 8));
+			CpuRead<Debug>(uint8_t(addressBus + 1));
+			CpuRead<Debug>(tempData | (dataBus << 8));
 			break;
 		case 0x04: case 0x05: case 0x24: case 0x25: case 0x44: case 0x45: case 0x64: //zero page R
 		case 0x65: case 0xA4: case 0xA5: case 0xA6: case 0xA7: case 0xC4: case 0xC5:
 		case 0xE4: case 0xE5:
 			++PC;
-			CpuRead(op1);
+			CpuRead<Debug>(op1);
 			break;
 		case 0x09: case 0x29: case 0x49: case 0x69: case 0x80: case 0x82: case 0x89: //immediate R
 		case 0xA0: case 0xA2: case 0xA9: case 0xAB: case 0xC0: case 0xC2: case 0xC9:
@@ -502,57 +692,57 @@ void Nes::RunOpcode()
 			break;
 		case 0x0C: case 0x0D: case 0x2C: case 0x2D: case 0x4D: case 0x6D: case 0xAC: //absolute R
 		case 0xAD: case 0xAE: case 0xAF: case 0xCC: case 0xCD: case 0xEC: case 0xED:
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 			++PC;
-			CpuRead(op1 | (dataBus << 8));
+			CpuRead<Debug>(op1 | (dataBus << 8));
 			break;
 		case 0x11: case 0x31: case 0x51: case 0x71: //(indirect),y / indirect indexed R
 		case 0xB1: case 0xD1: case 0xF1: case 0xB3:
 			++PC;
-			CpuRead(op1);
+			CpuRead<Debug>(op1);
 			tempData = dataBus;
-			CpuRead(uint8_t(op1 + 1));
-			CpuRead(uint8_t(tempData + rY) | (dataBus << 8));
+			CpuRead<Debug>(uint8_t(op1 + 1));
+			CpuRead<Debug>(uint8_t(tempData + rY) | (dataBus << 8));
 
 			if(tempData + rY > 0xFF)
 			{
-				CpuRead(addressBus + 0x0100);
+				CpuRead<Debug>(addressBus + 0x0100);
 			}
 			break;
 		case 0x14: case 0x15: case 0x34: case 0x35: case 0x54: case 0x55: case 0x74: //zero page,X R
 		case 0x75: case 0xB4: case 0xB5: case 0xD4: case 0xD5: case 0xF4: case 0xF5:	
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(op1 + rX));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(op1 + rX));
 			break;
 		case 0x19: case 0x39: case 0x59: case 0x79: case 0xB9: //absolute,Y R
 		case 0xBE: case 0xBF: case 0xD9: case 0xF9:
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 
 			++PC;
-			CpuRead(uint8_t(op1 + rY) + (dataBus << 8));
+			CpuRead<Debug>(uint8_t(op1 + rY) + (dataBus << 8));
 
 			if(op1 + rY > 0xFF)
 			{
-				CpuRead(addressBus + 0x0100);
+				CpuRead<Debug>(addressBus + 0x0100);
 			}
 			break;
 		case 0x1C: case 0x1D: case 0x3C: case 0x3D: case 0x5C: case 0x5D: case 0x7C: //absolute,X R
 		case 0x7D: case 0xBC: case 0xBD: case 0xDC: case 0xDD: case 0xFC: case 0xFD:
-			CpuRead(++PC);
+			CpuRead<Debug>(++PC);
 
 			++PC;
-			CpuRead(uint8_t(op1 + rX) + (dataBus << 8));
+			CpuRead<Debug>(uint8_t(op1 + rX) + (dataBus << 8));
 
 			if(op1 + rX > 0xFF)
 			{
-				CpuRead(addressBus + 0x0100);
+				CpuRead<Debug>(addressBus + 0x0100);
 			}
 			break;
 		case 0xB6: case 0xB7: //zero page,Y R
 			++PC;
-			CpuRead(op1);
-			CpuRead(uint8_t(addressBus + rY));
+			CpuRead<Debug>(op1);
+			CpuRead<Debug>(uint8_t(addressBus + rY));
 			break;
 	}
 
@@ -562,7 +752,7 @@ void Nes::RunOpcode()
 			++dataBus;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 		case 0xE1: case 0xE5: case 0xE9: case 0xEB: case 0xED: //sbc
 		case 0xF1: case 0xF5: case 0xF9: case 0xFD:
@@ -588,7 +778,7 @@ void Nes::RunOpcode()
 			}
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 		case 0x21: case 0x25: case 0x29: case 0x2D: //and
 		case 0x31: case 0x35: case 0x39: case 0x3D:
@@ -601,7 +791,7 @@ void Nes::RunOpcode()
 			--dataBus;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 		case 0xC1: case 0xC5: case 0xC9: case 0xCD: //cmp
 		case 0xD1: case 0xD5: case 0xD9: case 0xDD:
@@ -615,7 +805,7 @@ void Nes::RunOpcode()
 			dataBus >>= 1;
 			rP[1] = !dataBus;
 			rP.reset(7);
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 		case 0x41: case 0x45: case 0x49: case 0x4D: //eor
 		case 0x51: case 0x55: case 0x59: case 0x5D:
@@ -636,7 +826,7 @@ void Nes::RunOpcode()
 			dataBus <<= 1;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 		case 0x01: case 0x05: case 0x09: case 0x0D: //ora
 		case 0x11: case 0x15: case 0x19: case 0x1D:
@@ -683,7 +873,7 @@ void Nes::RunOpcode()
 			dataBus >>= 1;
 			rP[1] = !dataBus;
 			rP.reset(7);
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x06: case 0x0E: case 0x16: case 0x1E: //asl
@@ -691,7 +881,7 @@ void Nes::RunOpcode()
 			dataBus <<= 1;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x26: case 0x2E: case 0x36: case 0x3E: //rol
@@ -702,7 +892,7 @@ void Nes::RunOpcode()
 			}
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x66: case 0x6E: case 0x76: case 0x7E: //ror
@@ -713,21 +903,21 @@ void Nes::RunOpcode()
 			}
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0xC6: case 0xCE: case 0xD6: case 0xDE: //dec
 			--dataBus;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0xE6: case 0xEE: case 0xF6: case 0xFE: //inc
 			++dataBus;
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 		break;
 
 		case 0x63: case 0x67: case 0x6F: case 0x73: case 0x77: case 0x7B: case 0x7F: //rra
@@ -738,7 +928,7 @@ void Nes::RunOpcode()
 			}
 			rP[1] = !dataBus;
 			rP[7] = dataBus & 0x80;
-			CpuWrite(addressBus, dataBus);
+			CpuWrite<Debug>(addressBus, dataBus);
 
 			{
 			const uint8_t prevrA = rA;
@@ -754,11 +944,12 @@ void Nes::RunOpcode()
 	irqPending[2] |= irqPending[1]; //interrupt polling
 	nmiPending[2] |= nmiPending[1]; //
 
-	CpuRead(PC); //fetch next opcode
-	CpuOpDone();
+	CpuRead<Debug>(PC); //fetch next opcode
+	CpuOpDone<Debug>();
 }
 
 
+template<bool Debug>
 void Nes::Branch(const bool flag, const uint8_t op1)
 {
 	++PC;
@@ -769,7 +960,7 @@ void Nes::Branch(const bool flag, const uint8_t op1)
 
 		const uint16_t pagePC = PC + int8_t(op1);
 		PC = (PC & 0xFF00) | (pagePC & 0x00FF);
-		CpuRead(PC);
+		CpuRead<Debug>(PC);
 
 		irqPending[1] = false; //taken branch without page crossing doesn't check for irqs on second cycle
 		nmiPending[1] = false;
@@ -777,14 +968,16 @@ void Nes::Branch(const bool flag, const uint8_t op1)
 		if(PC != pagePC)
 		{
 			PC = pagePC;
-			CpuRead(PC);
+			CpuRead<Debug>(PC);
 		}
 	}
 }
 
 
+template<bool Debug>
 void Nes::CpuRead(const uint16_t address)
 {
+	const uint16_t vramAddress = Debug ? ppu.GetVramAddress() : 0; //before $2007 moves it
 	rw = 1;
 	addressBus = address;
 
@@ -795,9 +988,18 @@ void Nes::CpuRead(const uint16_t address)
 		case 0x2000 >> 13:
 			switch(addressBus & 7)
 			{
-				case 2: dataBus = ppu.StatusRead();  break;
+				case 2:
+					dataBus = ppu.StatusRead();
+					if(eventLog)
+					{
+						LogEvent(EventStatusRead, addressBus, dataBus);
+					}
+				break;
 				case 4: dataBus = ppu.OamDataRead(); break;
-				case 7: dataBus = ppu.DataRead();    break;
+				case 7:
+					dataBus = ppu.DataRead();
+					ScheduleIrq(MapperIrq, cycleCount); //A12 moved
+				break;
 			}
 		break;
 
@@ -805,22 +1007,26 @@ void Nes::CpuRead(const uint16_t address)
 			switch(addressBus)
 			{
 				case 0x4014: dataBus = 0x40;             break; //open bus, maybe hax something better later
-				case 0x4015: dataBus = apu.StatusRead(); break;
+				case 0x4015:
+					dataBus = apu.StatusRead();
+					ScheduleIrq(FrameCounterIrq, cycleCount); //reading acknowledges the frame irq
+				break;
 
-				case 0x4016:
-					dataBus = ((addressBus >> 8) & 0xE0) | (controller_reg & 1); //addressBus = open bus?
-					controller_reg >>= 1; //todo: if we have read 4016 8 times, start returning 1s
+				case 0x4016: case 0x4017:
+					dataBus = ((addressBus >> 8) & 0xE0) | ports.Read(addressBus & 1, cycleCount, ppu); //addressBus = open bus?
 				break;
 
-				case 0x4017:
-					dataBus = ((addressBus >> 8) & 0xE0) | (controller_reg2 & 1);
-					controller_reg2 >>= 1;
+				default:
+					if(addressBus >= 0x4020)
+					{
+						CartRegisterRead();
+					}
 				break;
 			}
 		break;
 
 		case 0x6000 >> 13:
-			if(prgRam.size()) //todo: maybe & with some generic cart.ramEnabled
+			if(prgRam.size() && prgRamEnable)
 			{
 				//todo: vrc4 with 2kb wram should return open bus if addressBus >= 0x7000
 				dataBus = pPrgRamBank[(addressBus >> 11) & 0b11][addressBus & 0x07FF];
@@ -839,32 +1045,38 @@ void Nes::CpuRead(const uint16_t address)
 
 	CpuTick();
 
-	if(apu.dmcDma && !dmcDmaActive) //check for dmc dma after read is finished (writes block this)
+	if(Debug && codeLogger)
 	{
-		dmcDmaActive = true;
-
-		const uint16_t tempAddr = addressBus;
-
-		if(!dmaPending)
+		if(address != PC) //fetches are logged as code with their instruction, or not at all if they're dummy reads
 		{
-			if(rw == 1)
-			{
-				CpuRead(addressBus);
-			}
-			CpuRead(addressBus);
+			LogPrg(address, CdlData, AccessRead);
 		}
+		const int32_t chrOffset = ((address & 0xE007) == 0x2007) ? ppu.ChrRomOffset(vramAddress) : -1;
+		if(chrOffset >= 0)
+		{
+			codeLogger->LogChr(chrOffset);
+		}
+	}
+	if(Debug && debugger)
+	{
+		DebugAccess(CpuSpace, address, BreakRead);
+		if((address & 0xE007) == 0x2007)
+		{
+			DebugAccess(PpuSpace, vramAddress, BreakRead);
+		}
+	}
 
-		CpuRead(apu.GetDmcAddr()); //dma fetch
-		apu.DmcDma(dataBus);
-		CpuRead(tempAddr); //resume
-
-		dmcDmaActive = false;
+	if(apu.dmcDma && !dmcDmaActive) //check for dmc dma after read is finished (writes block this)
+	{
+		DmcDma<Debug>();
 	}
 }
 
 
+template<bool Debug>
 void Nes::CpuWrite(const uint16_t address, const uint8_t data)
 {
+	const uint16_t vramAddress = Debug ? ppu.GetVramAddress() : 0;
 	rw = 0;
 	addressBus = address;
 	dataBus = data;
@@ -874,9 +1086,20 @@ void Nes::CpuWrite(const uint16_t address, const uint8_t data)
 		case 0x0000 >> 13: cpuRam[addressBus & 0x07FF] = dataBus; break;
 
 		case 0x2000 >> 13:
+			if(eventLog)
+			{
+				LogEvent(EventRegisterWrite, addressBus, dataBus);
+			}
 			switch(addressBus & 7)
 			{
-				case 0: ppu.CtrlWrite(dataBus);    break;
+				case 0:
+					ppu.CtrlWrite(dataBus);
+					if(type == EKROM) //mmc5 snoops the sprite size to pick chr banks
+					{
+						mmc5.sprite8x16 = dataBus & 0b00100000;
+						MMC5ChrUpdate();
+					}
+				break;
 				case 1: ppu.MaskWrite(dataBus);    break;
 				case 3: ppu.OamAddrWrite(dataBus); break;
 				case 4: ppu.OamDataWrite(dataBus); break;
@@ -884,6 +1107,10 @@ void Nes::CpuWrite(const uint16_t address, const uint8_t data)
 				case 6: ppu.AddrWrite(dataBus);    break;
 				case 7: ppu.DataWrite(dataBus);    break;
 			}
+			if((addressBus & 7) <= 1 || (addressBus & 6) == 6) //pattern tables or rendering switched or A12 moved, scanline counters look again
+			{
+				ScheduleIrq(MapperIrq, cycleCount);
+			}
 		break;
 
 		case 0x4000 >> 13:
@@ -913,18 +1140,37 @@ void Nes::CpuWrite(const uint16_t address, const uint8_t data)
 				case 0x4013: apu.Dmc3Write(dataBus);      break;
 
 				case 0x4014:
+					if(eventLog)
+					{
+						LogEvent(EventOamDma, addressBus, dataBus);
+					}
 					dmaPending = true;
 					dmaAddress = dataBus << 8;
 				break;
 
 				case 0x4015: apu.StatusWrite(dataBus);       break;
-				case 0x4016: readJoy1 = dataBus & 1;         break;
-				case 0x4017: apu.FrameCounterWrite(dataBus); break;
+				case 0x4016: ports.Strobe(dataBus);          break;
+				case 0x4017:
+					apu.FrameCounterWrite(dataBus);
+					ScheduleIrq(FrameCounterIrq, cycleCount);
+				break;
+
+				default:
+					if(addressBus >= 0x4020)
+					{
+						if(eventLog)
+						{
+							LogEvent(EventMapperWrite, addressBus, dataBus);
+						}
+						CartRegisterWrite();
+						ScheduleIrq(MapperIrq, cycleCount);
+					}
+				break;
 			}
 		break;
 
 		case 0x6000 >> 13:
-			if(prgRam.size()) //todo: maybe & with some generic cart.ramEnabled
+			if(prgRam.size() && prgRamEnable && prgRamWritable)
 			{
 				//todo: writes to vrc4 with 2kb wram should do nothing if addressBus >= 0x7000
 				pPrgRamBank[(addressBus >> 11) & 0b11][addressBus & 0x07FF] = dataBus;
@@ -932,11 +1178,66 @@ void Nes::CpuWrite(const uint16_t address, const uint8_t data)
 		break;
 
 		case 0x8000 >> 13: case 0xA000 >> 13: case 0xC000 >> 13: case 0xE000 >> 13:
+			if(eventLog)
+			{
+				LogEvent(EventMapperWrite, addressBus, dataBus);
+			}
 			Addons();
+			ScheduleIrq(MapperIrq, cycleCount);
 		break;
 	}
 
 	CpuTick();
+
+	if(Debug && codeLogger)
+	{
+		LogPrg(address, 0, AccessWrite);
+	}
+	if(Debug && debugger)
+	{
+		DebugAccess(CpuSpace, address, BreakWrite);
+		if((address & 0xE007) == 0x2007)
+		{
+			DebugAccess(PpuSpace, vramAddress, BreakWrite);
+		}
+	}
+}
+
+
+void Nes::DebugAccess(const DebugSpace space, const uint16_t address, const uint8_t type)
+{
+	if(debugger->Wants(space, address, type))
+	{
+		debugger->Access(space, type, {instructionPC, address, rA, rX, rY, rS, uint8_t(rP.to_ulong()), dataBus, ppu.GetScanlineV(), ppu.GetScanlineH(), cycleCount});
+	}
+}
+
+
+void Nes::LogPrg(const uint16_t address, const uint8_t flags, const CdlAccess access)
+{
+	const int32_t offset = PrgRomOffset(address);
+	if(offset >= 0)
+	{
+		codeLogger->LogPrg(offset, flags | ((address >> 11) & 0b1100), access);
+	}
+}
+
+
+const int32_t Nes::PrgRomOffset(const uint16_t address) const
+{
+	const uint8_t *byte = pPrgBank[(address >> 13) & 0b11] + (address & 0x1FFF);
+	if(address < 0x8000 || byte < prgRom.data() || byte >= prgRom.data() + prgRom.size())
+	{
+		return -1;
+	}
+	return byte - prgRom.data();
+}
+
+
+const uint32_t Nes::ProfileLocation(const uint16_t address) const
+{
+	const int32_t offset = PrgRomOffset(address);
+	return (offset >= 0) ? 0x8000 + offset : address & 0x7FFF; //ram mapped at $8000 shares with wram
 }
 
 
@@ -951,53 +1252,128 @@ void Nes::CpuTick()
 }
 
 
-void Nes::CpuOpDone()
+template<bool Debug>
+void Nes::OamDma()
 {
-	if(dmaPending)
+	// DMA actually waits for writes to finish, not op to finish
+	// however, this makes no difference for OAM DMA
+	if(cycleCount & 1)
+	{
+		CpuRead(PC); //read what? doesn't really matter, maybe addressBus
+	}
+
+	//nothing looks at oam while the ppu isn't rendering, so a page without read side effects can be copied
+	//at once and only the clocks run. dmc dma still steals its cycles in between exactly as below.
+	//the checked core takes the slow path so breakpoints and the code logger see every read
+	const uint8_t *page = Debug ? nullptr : DmaPage(dmaAddress >> 8);
+	const uint16_t scanline = ppu.GetScanlineV();
+	if(page && (!ppu.RenderingEnabled() || (scanline >= 240 && scanline < 261 && ppu.DotsUntil(261, 0) > 3 * 600)))
 	{
-		// DMA actually waits for writes to finish, not op to finish
-		// however, this makes no difference for OAM DMA
-		if(cycleCount & 1)
+		ppu.OamDma(page);
+		for(uint16_t x = 0; x < 256; ++x)
 		{
-			CpuRead(PC); //read what? doesn't really matter, maybe addressBus
-		}
+			rw = 1;
+			addressBus = dmaAddress + x;
+			dataBus = page[x];
+			CpuTick();
+			if(apu.dmcDma && !dmcDmaActive)
+			{
+				DmcDma<false>();
+			}
 
+			rw = 0;
+			addressBus = 0x2004;
+			CpuTick();
+		}
+	}
+	else
+	{
 		for(int x = 0; x < 256; ++x)
 		{
-			CpuRead(dmaAddress + x); //should dmaAddress be 1st or 2nd write from R&W ops (2nd currently)?
-			CpuWrite(0x2004, dataBus);
+			CpuRead<Debug>(dmaAddress + x); //should dmaAddress be 1st or 2nd write from R&W ops (2nd currently)?
+			CpuWrite<Debug>(0x2004, dataBus);
 		}
+	}
+
+	CpuRead(PC);
+	dmaPending = false;
+}
+
+
+template<bool Debug>
+void Nes::DmcDma()
+{
+	dmcDmaActive = true;
+
+	const uint16_t tempAddr = addressBus;
+
+	if(!dmaPending) //during oam dma the cpu is already halted and the dmc takes its next free read
+	{
+		if(rw == 1)
+		{
+			CpuRead(addressBus);
+		}
+		CpuRead(addressBus);
+	}
+
+	if(Debug && codeLogger)
+	{
+		LogPrg(apu.GetDmcAddr(), CdlData | CdlPcm, AccessRead);
+	}
+	CpuRead<Debug>(apu.GetDmcAddr()); //dma fetch, the halt and resume reads repeat what the cpu reads anyway
+	apu.DmcDma(dataBus);
+	CpuRead(tempAddr); //resume
 
-		CpuRead(PC);
-		dmaPending = false;
+	dmcDmaActive = false;
+}
+
+
+const uint8_t* Nes::DmaPage(const uint8_t page) //null for pages with registers or open bus
+{
+	switch(page >> 5)
+	{
+		case 0x00 >> 5: return &cpuRam[(page & 0x07) << 8];
+		case 0x60 >> 5: return (prgRam.size() && prgRamEnable) ? pPrgRamBank[(page >> 3) & 0b11] + ((page & 0x07) << 8) : nullptr;
+		case 0x80 >> 5: case 0xA0 >> 5: case 0xC0 >> 5: case 0xE0 >> 5: return pPrgBank[(page >> 5) & 0b11] + ((page & 0x1F) << 8);
+		default: return nullptr;
 	}
+}
+
 
-	if(nmiPending[2] | irqPending[2])
+template<bool Debug>
+void Nes::CpuOpDone()
+{
+	if(dmaPending)
 	{
-		CpuRead(addressBus);                                //fetch op1, increment suppressed
-		CpuWrite(0x100 | rS--, PC >> 8);                    //push PC high on stack
-		CpuWrite(0x100 | rS--, PC);                         //push PC low on stack
-		CpuWrite(0x100 | rS--, rP.to_ulong() & 0b11101111); //push flags on stack with B clear
+		OamDma<Debug>();
+	}
 
-		#ifdef DEBUG
-			if(nmiPending[1]) std::cout << "NMI ";
-			else              std::cout << "IRQ ";
-		#endif
+	if((nmiPending[2] | irqPending[2]) && !jammed)
+	{
+		CpuRead<Debug>(addressBus);                                //fetch op1, increment suppressed
+		CpuWrite<Debug>(0x100 | rS--, PC >> 8);                    //push PC high on stack
+		CpuWrite<Debug>(0x100 | rS--, PC);                         //push PC low on stack
+		CpuWrite<Debug>(0x100 | rS--, rP.to_ulong() & 0b11101111); //push flags on stack with B clear
 
 		//determine if this is an IRQ or NMI, also see if NMI will hijack an IRQ (0xFFFE -> 0xFFFA)
 		const uint16_t interruptVector = 0xFFFE ^ (nmiPending[1] << 2);
 		nmiPending[0] &= !nmiPending[1];                    //toggle nmi[0] since it gets stuck on
 
-		CpuRead(interruptVector);                           //read vector low, set I flag
+		CpuRead<Debug>(interruptVector);                           //read vector low, set I flag
 		tempData = dataBus;                                 //
 		rP.set(2);                                          //
 
 		irqPending[2] = false;                              //clear interrupts
 		nmiPending[2] = false;                              //
 
-		CpuRead(interruptVector + 1);                       //read vector high
+		CpuRead<Debug>(interruptVector + 1);                       //read vector high
 		PC = tempData | (dataBus << 8);                     //fetch next opcode
-		CpuRead(PC);                                        //
+		CpuRead<Debug>(PC);                                        //
+
+		if(Debug && profiler)
+		{
+			profiler->Interrupt(ProfileLocation(PC), PC, cycleCount, rS + 3, (interruptVector == 0xFFFA) ? ProfileNmi : ProfileIrq);
+		}
 	}
 }
 
@@ -1010,423 +1386,135 @@ void Nes::PollInterrupts()
 	nmiPending[0] |= !oldNmi & nmi; //nmiPending[0] gets set = nmi detected, but interrupt polling will miss
 
 	irqPending[1] = irqPending[0]; //same as nmi
-	irqPending[0] = !rP.test(2) & (apu.PollFrameInterrupt() | VRC4Interrupt() | MMC3Interrupt()); //OR with some general cartIRQ later
-}
-
-
-void Nes::DebugCpu(uint8_t opcode)
-{
-	const std::array<std::string, 256> opName
+	if(int32_t(cycleCount - irqScheduler.next) >= 0) //irq sources only need to be looked at when a deadline has passed
 	{
-		"BRK","ORA","KIL","SLO","NOP","ORA","ASL","SLO","PHP","ORA","ASL","ANC","NOP","ORA","ASL","SLO",
-		"BPL","ORA","KIL","SLO","NOP","ORA","ASL","SLO","CLC","ORA","NOP","SLO","NOP","ORA","ASL","SLO",
-		"JSR","AND","KIL","RLA","BIT","AND","ROL","RLA","PLP","AND","ROL","ANC","BIT","AND","ROL","RLA",
-		"BMI","AND","KIL","RLA","NOP","AND","ROL","RLA","SEC","AND","NOP","RLA","NOP","AND","ROL","RLA",
-		"RTI","EOR","KIL","SRE","NOP","EOR","LSR","SRE","PHA","EOR","LSR","ALR","JMP","EOR","LSR","SRE",
-		"BVC","EOR","KIL","SRE","NOP","EOR","LSR","SRE","CLI","EOR","NOP","SRE","NOP","EOR","LSR","SRE",
-		"RTS","ADC","KIL","RRA","NOP","ADC","ROR","RRA","PLA","ADC","ROR","ARR","JMP","ADC","ROR","RRA",
-		"BVS","ADC","KIL","RRA","NOP","ADC","ROR","RRA","SEI","ADC","NOP","RRA","NOP","ADC","ROR","RRA",
-		"NOP","STA","NOP","SAX","STY","STA","STX","SAX","DEY","NOP","TXA","XAA","STY","STA","STX","SAX",
-		"BCC","STA","KIL","AHX","STY","STA","STX","SAX","TYA","STA","TXS","TAS","SHY","STA","SHX","AHX",
-		"LDY","LDA","LDX","LAX","LDY","LDA","LDX","LAX","TAY","LDA","TAX","LAX","LDY","LDA","LDX","LAX",
-		"BCS","LDA","KIL","LAX","LDY","LDA","LDX","LAX","CLV","LDA","TSX","LAS","LDY","LDA","LDX","LAX",
-		"CPY","CMP","NOP","DCP","CPY","CMP","DEC","DCP","INY","CMP","DEX","AXS","CPY","CMP","DEC","DCP",
-		"BNE","CMP","KIL","DCP","NOP","CMP","DEC","DCP","CLD","CMP","NOP","DCP","NOP","CMP","DEC","DCP",
-		"CPX","SBC","NOP","ISC","CPX","SBC","INC","ISC","INX","SBC","NOP","SBC","CPX","SBC","INC","ISC",
-		"BEQ","SBC","KIL","ISC","NOP","SBC","INC","ISC","SED","SBC","NOP","ISC","NOP","SBC","INC","ISC"
-	};
-
-	std::cout << std::uppercase << std::hex << std::setfill('0')
-			  << std::setw(4) << PC
-			  << "  " << std::setw(2) << +opcode
-			  << " " << std::setw(4) << (DebugRead(PC+1) + (DebugRead(PC+2) << 8))
-			  << "  " << opName[opcode]
-			  << "    A:" << std::setw(2) << +rA
-			  << " X:" << std::setw(2) << +rX
-			  << " Y:" << std::setw(2) << +rY
-			  << " P:" << std::setw(2) << (rP.to_ulong() & ~0x10)
-			  << " SP:" << std::setw(2) << +rS
-			  << " PPU:" << std::setw(3) << std::dec << ppu.GetScanlineH()
-			  << " SL:" << std::setw(3) << ppu.GetScanlineV() << std::endl;
+		UpdateIrqs();
+	}
+	irqPending[0] = !rP.test(2) & irqScheduler.line;
 }
 
 
-uint8_t Nes::DebugRead(uint16_t address)
+void Nes::ScheduleIrq(const IrqSource source, const uint32_t cycle)
 {
-	uint8_t a = 0;
-	switch(address & 0xE000)
+	//cpu accesses that can change an irq line schedule the source for the current cycle
+	irqScheduler.deadline[source] = cycle;
+	if(int32_t(cycle - irqScheduler.next) < 0)
 	{
-		case 0x0000: case 0x2000: case 0x4000: case 0x6000:
-				std::cout << "running code below 0x8000, at 0x"
-				<< std::uppercase << std::hex << std::setfill('0') << std::setw(4) << address << "\n";
-		break;
-
-		case 0x8000: a = pPrgBank[0][address & 0x1FFF]; break;
-		case 0xA000: a = pPrgBank[1][address & 0x1FFF]; break;
-		case 0xC000: a = pPrgBank[2][address & 0x1FFF]; break;
-		case 0xE000: a = pPrgBank[3][address & 0x1FFF]; break;
+		irqScheduler.next = cycle;
 	}
-
-	return a;
 }
 
 
-//put this elsewhere later
-void Nes::Addons()
+void Nes::UpdateIrqs()
 {
-	switch(type)
-	{
-		case UNROM:
-			pPrgBank[0] = &prgRom[(dataBus & 0b1111) * 0x4000];
-			pPrgBank[1] = pPrgBank[0] + 0x2000;
-		break;
-
-		case CNROM:
-			ppu.SetPatternBanks8(dataBus & 0b0011);
-		break;
+	const uint32_t idle = cycleCount + 0x40000000; //far enough away to not matter, close enough to not wrap
 
-		case AOROM:
-			pPrgBank[0] = &prgRom[(dataBus & 0b0111) * 0x8000];
-			pPrgBank[1] = pPrgBank[0] + 0x2000;
-			pPrgBank[2] = pPrgBank[0] + 0x4000;
-			pPrgBank[3] = pPrgBank[0] + 0x6000;
-
-			if(dataBus & 0b00010000)
-			{
-				ppu.SetNametableArrangement({B,B,B,B});
-			}
-			else
-			{
-				ppu.SetNametableArrangement({A,A,A,A});
-			}
-		break;
-
-		case SFROM: MMC1Registers(); break;
-		case TLROM: MMC3Registers(); break;
-		case VRC_4: VRC4Registers(); break;
+	if(int32_t(cycleCount - irqScheduler.deadline[FrameCounterIrq]) >= 0)
+	{
+		irqScheduler.level[FrameCounterIrq] = apu.PollFrameInterrupt();
+		irqScheduler.deadline[FrameCounterIrq] = cycleCount + apu.FrameInterruptDelay();
 	}
-}
-
 
-void Nes::MMC1Registers()
-{
-	if(mmc1.lastWrittenTo != cycleCount - 1) //compare with previous write to disallow consecutive writes
+	if(int32_t(cycleCount - irqScheduler.deadline[MapperIrq]) >= 0)
 	{
-		if(dataBus & 0x80)
-		{
-			mmc1.shiftReg = 0b100000;
-			mmc1.prgMode = 0b11;
-			pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
-			pPrgBank[1] = pPrgBank[0] + 8 * 1024;
-			pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
-			pPrgBank[3] = pPrgBank[2] + 8 * 1024;
-		}
-		else
+		switch(type)
 		{
-			mmc1.shiftReg |= (dataBus & 1) << 6;
-			mmc1.shiftReg >>= 1;
-			if(mmc1.shiftReg & 1)
-			{
-				mmc1.shiftReg >>= 1;
-				switch(addressBus >> 13)
-				{
-					case 0x8000 >> 13:
-						switch(mmc1.shiftReg & 0b11)
-						{
-							case 0: ppu.SetNametableArrangement({A,A,A,A}); break;
-							case 1: ppu.SetNametableArrangement({B,B,B,B}); break;
-							case 2: ppu.SetNametableArrangement({A,B,A,B}); break;
-							case 3: ppu.SetNametableArrangement({A,A,B,B}); break;
-						}
+			case TLROM:
+				irqScheduler.level[MapperIrq] = MMC3Interrupt();
 
-						mmc1.prgMode = (mmc1.shiftReg >> 2) & 0b11;
-						switch(mmc1.prgMode)
-						{
-							case 0: case 1: //32k mode
-								pPrgBank[0] = prgRom.data() + ((mmc1.prg & 0b11110) << 14);
-								pPrgBank[2] = pPrgBank[0] + 16 * 1024;
-							break;
-							case 2: //low bank fixed, high switchable
-								pPrgBank[0] = prgRom.data();
-								pPrgBank[2] = prgRom.data() + (mmc1.prg << 14);
-							break;
-							case 3: //high bank fixed, low switchable
-								pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
-								pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
-							break;
-						}
-						pPrgBank[1] = pPrgBank[0] + 8 * 1024;
-						pPrgBank[3] = pPrgBank[2] + 8 * 1024;
+				//A12 only changes while rendering or through $2006/$2007. once the filter has settled it only has to look again
+				//a little before the next fetch that can move it, or when a register write changes what's fetched
+				if(mmc3.A12[0] != mmc3.A12[1] || mmc3.A12[0] != mmc3.A12[2])
+				{
+					irqScheduler.deadline[MapperIrq] = cycleCount;
+				}
+				else if(ppu.RenderingEnabled())
+				{
+					const uint32_t dots = ppu.DotsUntilA12Change();
+					irqScheduler.deadline[MapperIrq] = (dots / 3 > 2) ? cycleCount + dots / 3 - 2 : cycleCount;
+				}
+				else
+				{
+					irqScheduler.deadline[MapperIrq] = idle;
+				}
+			break;
 
-						mmc1.chrMode = mmc1.shiftReg >> 4;
-						if(mmc1.chrMode == 1)
-						{
-							ppu.SetPatternBanks4(0, mmc1.chr0);
-							ppu.SetPatternBanks4(1, mmc1.chr1);
-						}
-						else
-						{
-							ppu.SetPatternBanks8(mmc1.chr0 >> 1);
-						}
-					break;
+			case VRC_4: case VRC_6a: case VRC_6b:
+				irqScheduler.level[MapperIrq] = VrcInterrupt();
+				irqScheduler.deadline[MapperIrq] = vrcIrq.enable ? VrcIrqNext() : idle;
+			break;
 
-					case 0xA000 >> 13:
-						mmc1.chr0 = mmc1.shiftReg;
-						if(mmc1.chrMode == 1)
-						{
-							ppu.SetPatternBanks4(0, mmc1.chr0);
-						}
-						else
-						{
-							ppu.SetPatternBanks8(mmc1.chr0 >> 1);
-						}
-					break;
+			case EKROM:
+				irqScheduler.level[MapperIrq] = MMC5Interrupt();
+				irqScheduler.deadline[MapperIrq] = MMC5NextIrq();
+			break;
 
-					case 0xC000 >> 13:
-						mmc1.chr1 = mmc1.shiftReg;
-						if(mmc1.chrMode == 1)
-						{
-							ppu.SetPatternBanks4(1, mmc1.chr1);
-						}
-					break;
+			case JLROM:
+				irqScheduler.level[MapperIrq] = FME7Interrupt();
+				irqScheduler.deadline[MapperIrq] = (fme7.irqEnable && fme7.irqCounterEnable) ? fme7.lastCycle + fme7.irqCounter : idle;
+			break;
 
-					case 0xE000 >> 13:
-						mmc1.prg = mmc1.shiftReg & 0b01111;
-						switch(mmc1.prgMode)
-						{
-							case 0: case 1: //32k mode
-								pPrgBank[0] = prgRom.data() + ((mmc1.prg & 0b11110) << 14);
-								pPrgBank[2] = pPrgBank[0] + 16 * 1024;
-							break;
-							case 2: //low bank fixed, high switchable
-								pPrgBank[0] = prgRom.data();
-								pPrgBank[2] = prgRom.data() + (mmc1.prg << 14);
-							break;
-							case 3: //high bank fixed, low switchable
-								pPrgBank[0] = prgRom.data() + (mmc1.prg << 14);
-								pPrgBank[2] = prgRom.data() + prgRom.size() - 16 * 1024;
-							break;
-						}
-						pPrgBank[1] = pPrgBank[0] + 8 * 1024;
-						pPrgBank[3] = pPrgBank[2] + 8 * 1024;
-						mmc1.wramEnable = mmc1.shiftReg & 0b10000;
-					break;
+			case N_163:
+				irqScheduler.level[MapperIrq] = N163Interrupt();
+				if((n163.irqCounter & 0x8000) && n163.irqCounter != 0xFFFF)
+				{
+					irqScheduler.deadline[MapperIrq] = n163.lastCycle + 0x7FFF - (n163.irqCounter & 0x7FFF) - 1;
 				}
-				mmc1.shiftReg = 0b100000;
-			}
+				else
+				{
+					irqScheduler.deadline[MapperIrq] = idle;
+				}
+			break;
+
+			default:
+				irqScheduler.deadline[MapperIrq] = idle;
+			break;
 		}
 	}
-	mmc1.lastWrittenTo = cycleCount;
-}
 
-
-void Nes::MMC3Registers()
-{
-	switch(((addressBus >> 12) & 0b0110) | (addressBus & 1))
+	const bool oldLine = irqScheduler.line;
+	irqScheduler.line = irqScheduler.level[FrameCounterIrq] | irqScheduler.level[MapperIrq];
+	if(eventLog && irqScheduler.line && !oldLine)
 	{
-		case 0: //8000
-			mmc3.bankRegSelect = dataBus & 0b0111;
-			mmc3.prgMode = dataBus & 0b01000000;
-			mmc3.chrMode = dataBus & 0b10000000;
-
-			pPrgBank[mmc3.prgMode << 1] = &prgRom[mmc3.bankReg[6] << 13];
-			pPrgBank[!mmc3.prgMode << 1] = &prgRom[prgRom.size() - 16 * 1024];
-
-			ppu.SetPatternBanks2((mmc3.chrMode << 1)    , mmc3.bankReg[0]);
-			ppu.SetPatternBanks2((mmc3.chrMode << 1) | 1, mmc3.bankReg[1]);
-
-			ppu.SetPatternBanks1((!mmc3.chrMode << 2)    , mmc3.bankReg[2]);
-			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 1, mmc3.bankReg[3]);
-			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 2, mmc3.bankReg[4]);
-			ppu.SetPatternBanks1((!mmc3.chrMode << 2) | 3, mmc3.bankReg[5]);
-
-		break;
-
-		case 1: //8001
-			mmc3.bankReg[mmc3.bankRegSelect] = dataBus;
-
-			switch(mmc3.bankRegSelect)
-			{
-				case 0: case 1:
-					mmc3.bankReg[mmc3.bankRegSelect] >>= 1;
-					ppu.SetPatternBanks2((mmc3.chrMode << 1) | mmc3.bankRegSelect, mmc3.bankReg[mmc3.bankRegSelect]);
-				break;
-
-				case 2: case 3: case 4: case 5:
-					ppu.SetPatternBanks1((!mmc3.chrMode << 2) | (mmc3.bankRegSelect - 2), mmc3.bankReg[mmc3.bankRegSelect]);
-				break;
-
-				case 6:
-					mmc3.bankReg[6] &= 0b00111111;
-					pPrgBank[mmc3.prgMode << 1] = &prgRom[mmc3.bankReg[6] << 13];
-				break;
-
-				case 7:
-					mmc3.bankReg[7] &= 0b00111111;
-					pPrgBank[1] = &prgRom[mmc3.bankReg[7] << 13];
-				break;
-			}
-		break;
-
-		case 2: //A000
-			if(dataBus & 1)
-			{
-				ppu.SetNametableArrangement({A, A, B, B});
-			}
-			else
-			{
-				ppu.SetNametableArrangement({A, B, A, B});
-			}
-		break;
-
-		case 3: //A001
-		break;
-
-		case 4: //C000
-			mmc3.irqLatch = dataBus;
-		break;
-
-		case 5: //C001
-			mmc3.irqReload = true;
-			//also set counter to 0?
-		break;
-
-		case 6: //E000
-			mmc3.irqEnable = false;
-			mmc3.irqPending = false;
-		break;
-
-		case 7: //E001
-			mmc3.irqEnable = true;
-		break;
+		LogEvent(EventIrq, 0, irqScheduler.level[FrameCounterIrq] | (irqScheduler.level[MapperIrq] << 1));
 	}
-}
 
-
-bool Nes::MMC3Interrupt()
-{
-	//todo: investigate revision differences
-
-	mmc3.A12[2] = mmc3.A12[1];
-	mmc3.A12[1] = mmc3.A12[0];
-	mmc3.A12[0] = ppu.GetA12();
-
-	if(mmc3.A12[0] && !(mmc3.A12[1] | mmc3.A12[2])) //clock irq via A12 0 -> 0 -> 1 change
+	irqScheduler.next = irqScheduler.deadline[FrameCounterIrq];
+	if(int32_t(irqScheduler.deadline[MapperIrq] - irqScheduler.next) < 0)
 	{
-		if(mmc3.irqReload || mmc3.irqCounter == 0)
-		{
-			mmc3.irqCounter = mmc3.irqLatch;
-			mmc3.irqReload = false;
-		}
-		else
-		{
-			--mmc3.irqCounter;
-		}
-
-		if(mmc3.irqCounter == 0)
-		{
-			mmc3.irqPending |= mmc3.irqEnable;
-		}
+		irqScheduler.next = irqScheduler.deadline[MapperIrq];
 	}
-
-	return mmc3.irqPending;
 }
 
 
-void Nes::VRC4Registers()
+uint8_t Nes::DebugRead(uint16_t address) //no side effects, registers read as 0
 {
-	const uint16_t vrc4Address = (addressBus & 0xFF00) | ((addressBus & 0xFF) >> 2);
-	switch(vrc4Address)
+	switch(address >> 13)
 	{
-		case 0x8000: case 0x8001: case 0x8002: case 0x8003:
-			pPrgBank[vrc4.prgMode] = prgRom.data() + ((dataBus & 0b00011111) << 13);
-		break;
-		case 0x9000: case 0x9001:
-			switch(dataBus & 0b11)
-			{
-				case 0: ppu.SetNametableArrangement({A,B,A,B}); break;
-				case 1: ppu.SetNametableArrangement({A,A,B,B}); break;
-				case 2: ppu.SetNametableArrangement({A,A,A,A}); break;
-				case 3: ppu.SetNametableArrangement({B,B,B,B}); break;
-			}
-		break;
-		case 0x9002: case 0x9003:
-			if(vrc4.prgMode != dataBus & 0b10)
-			{
-				uint8_t *tempBank = pPrgBank[0];
-				pPrgBank[0] = pPrgBank[2];
-				pPrgBank[2] = tempBank;
-			}
-			vrc4.prgMode = dataBus & 0b10;
-		break;
-		case 0xA000: case 0xA001: case 0xA002: case 0xA003:
-			pPrgBank[1] = prgRom.data() + ((dataBus & 0b00011111) << 13);
-		break;
-
-		case 0xB000: case 0xB002: case 0xC000: case 0xC002: case 0xD000: case 0xD002: case 0xE000: case 0xE002:
-		{
-			const uint8_t regSelect = ((vrc4Address >> 11) - 0x16) | ((vrc4Address >> 1) & 1);
-			vrc4.chrSelect[regSelect] = (vrc4.chrSelect[regSelect] & 0x01F0) | (dataBus & 0b1111);
-			ppu.SetPatternBanks1(regSelect, vrc4.chrSelect[regSelect]);
-		}
-		break;
-		case 0xB001: case 0xB003: case 0xC001: case 0xC003: case 0xD001: case 0xD003: case 0xE001: case 0xE003:
-		{
-			const uint8_t regSelect = ((vrc4Address >> 11) - 0x16) | ((vrc4Address >> 1) & 1);
-			vrc4.chrSelect[regSelect] = (vrc4.chrSelect[regSelect] & 0x0F) | ((dataBus & 0b00011111) << 4);
-			ppu.SetPatternBanks1(regSelect, vrc4.chrSelect[regSelect]);
-		}
-		break;
-
-		case 0xF000:
-			vrc4.irqLatch &= 0b11110000;
-			vrc4.irqLatch |= dataBus & 0b1111;
-		break;
-		case 0xF001:
-			vrc4.irqLatch &= 0b1111;
-			vrc4.irqLatch |= dataBus << 4;
-		break;
-		case 0xF002:
-			vrc4.irqPending = false;
-			vrc4.irqAckEnable = dataBus & 1;
-			vrc4.irqEnable = dataBus & 0b10;
-			vrc4.irqMode = dataBus & 0b0100;
-			if(vrc4.irqEnable)
-			{
-				vrc4.irqCounter = vrc4.irqLatch;
-				vrc4.prescalerCounter2 = 341;
-			}
-		break;
-		case 0xF003:
-			vrc4.irqPending = false;
-			vrc4.irqEnable = vrc4.irqAckEnable;
-		break;
+		case 0x0000 >> 13: return cpuRam[address & 0x07FF];
+		case 0x6000 >> 13: return (prgRam.size() && prgRamEnable) ? pPrgRamBank[(address >> 11) & 0b11][address & 0x07FF] : 0;
+		case 0x8000 >> 13: return pPrgBank[0][address & 0x1FFF];
+		case 0xA000 >> 13: return pPrgBank[1][address & 0x1FFF];
+		case 0xC000 >> 13: return pPrgBank[2][address & 0x1FFF];
+		case 0xE000 >> 13: return pPrgBank[3][address & 0x1FFF];
+		default: return 0;
 	}
 }
 
 
-bool Nes::VRC4Interrupt()
+void Nes::DebugWrite(uint16_t address, uint8_t data)
 {
-	if(vrc4.irqEnable)
+	switch(address >> 13)
 	{
-		if(vrc4.irqCounter == 0xFF)
-		{
-			vrc4.irqPending = true;
-			vrc4.irqCounter = vrc4.irqLatch;
-		}
-		else if(vrc4.irqMode == true)
-		{
-			++vrc4.irqCounter;
-		}
-		else
-		{
-			vrc4.prescalerCounter2 -= 3;
-			if(vrc4.prescalerCounter2 <= 0)
+		case 0x0000 >> 13: cpuRam[address & 0x07FF] = data; break;
+		case 0x6000 >> 13:
+			if(prgRam.size() && prgRamEnable)
 			{
-				++vrc4.irqCounter;
-				vrc4.prescalerCounter2 += 341;
+				pPrgRamBank[(address >> 11) & 0b11][address & 0x07FF] = data;
 			}
-		}
+		break;
+		case 0x8000 >> 13: case 0xA000 >> 13: case 0xC000 >> 13: case 0xE000 >> 13:
+			pPrgBank[(address >> 13) & 0b11][address & 0x1FFF] = data;
+		break;
 	}
-	return vrc4.irqPending;
 }
@@ -7,109 +7,175 @@
 #include "apu.hpp"
 #include "ppu.hpp"
 #include "cart.hpp"
+#include "codelog.hpp"
+#include "debugger.hpp"
+#include "profiler.hpp"
+#include "eventlog.hpp"
+#include "input.hpp"
+#include "mapper.hpp"
+#include "savefile.hpp"
+#include "state.hpp"
+#include "trace.hpp"
 
 struct NesInfo
 {
     uint8_t rA, rX, rY, rS;
+    uint32_t cycles; //wraps, only differences mean anything
 };
 
-struct VRC4
-{
-	std::array<uint16_t, 8> chrSelect{};
-	int16_t prescalerCounter2 = 341;
-	uint8_t prgMode = 0;
-	uint8_t irqLatch = 0;
-	uint8_t irqCounter = 0;
-	bool irqPending = false;
-	bool irqEnable = false;
-	bool irqAckEnable = false;
-	bool irqMode = false;
-};
+enum FrameSkip : uint8_t {SkipNone = 0, SkipVideo = 1, SkipAudio = 2, SkipInputPoll = 4}; //output nobody will see or hear, timing stays exact. no poll = the input stays as given
 
-struct MMC1
-{
-	uint32_t lastWrittenTo = 0;
-	uint8_t shiftReg = 0b100000;
-	uint8_t prgMode = 0b11;
-	uint8_t prg = 0;
-	bool wramEnable = 0;
-	bool chrMode = 0;
-	uint8_t chr0 = 0;
-	uint8_t chr1 = 0;
-};
+enum IrqSource : uint8_t {FrameCounterIrq = 0, MapperIrq = 1};
 
-struct MMC3
+struct IrqScheduler
 {
-	std::array<uint8_t, 8> bankReg{};
-	uint8_t bankRegSelect, irqLatch = 0, irqCounter = 0;
-	bool prgMode, chrMode, irqEnable = 0, irqPending = 0, irqReload = 0;
-	std::array<bool, 3> A12{};
+	std::array<uint32_t, 2> deadline{}; //cycle at which each source has to be polled again
+	std::array<bool, 2> level{};
+	uint32_t next = 0;                  //earliest deadline
+	bool line = false;
 };
 
 class Nes
 {
 	public:
-		Nes(std::string inFile);
-		void AdvanceFrame(uint8_t input, uint8_t input2);
+		Nes(std::string inFile, const BatteryMode battery = BatteryFile); //instances sharing a rom in one process can't share its mapped .sav
+		const bool Loaded() const; //false if the rom couldn't be read or its board isn't supported, nothing else may be called then
+		const bool Jammed() const; //the cpu ran into a KIL opcode, only a reset gets it going again
+		void AdvanceFrame(const InputFrame &input, const uint8_t skip = SkipNone);
+		void AdvanceFrame(const uint8_t input, const uint8_t input2, const uint8_t skip = SkipNone); //the standard pads only
+		void RunAhead(const uint8_t frames); //shows the frame that many frames ahead with the held input, then rolls back. off while a tool is attached
 
 		const NesInfo GetInfo() const;
+		const std::array<uint32_t, 5> GetRomSha1() const;
+
+		void SaveState(std::vector<uint8_t> &buffer);
+		bool LoadState(const std::vector<uint8_t> &buffer); //leaves the emulator untouched if the state is for another rom or damaged
+		const uint32_t PrgRamHash();
+		const bool BatteryMapped() const; //prg ram writes, a loaded state included, go to the .sav
+
+		void SetInputDevice(const uint8_t port, const InputDevice device); //pads in both ports at power on
+		const InputDevice GetInputDevice(const uint8_t port) const;
+		void SetInputPoll(std::function<void(InputFrame&)> poll); //called at a frame's first $4016 strobe to sample the input as late as possible
+		const InputFrame& GetInput() const; //what the last frame ran with, polled or not
+		void SetTrace(Trace *newTrace); //records every instruction that passes its filters, null stops tracing
+		void SetDebugger(Debugger *newDebugger); //runs the checked cpu core while attached, null detaches
+		void SetCodeLogger(CodeLogger *newLogger); //same, sizes the logger for this rom
+		void SetProfiler(Profiler *newProfiler);   //same, counting starts at the next instruction
+		void SetEventLog(EventLog *newLog); //ppu and mapper register accesses with the beam position, null stops logging
+		uint8_t DebugRead(uint16_t address); //ram, wram and prg rom without side effects, registers read as 0
+		void DebugWrite(uint16_t address, uint8_t data); //ram, wram and prg rom, registers are left alone
+		void Reset();
 
 		Ppu ppu;
 		Apu apu;
 
 	private:
-		void Reset();
-
-		void RunOpcode();
-		void Branch(const bool flag, const uint8_t op1);
-		void CpuRead(const uint16_t address);
-		void CpuWrite(const uint16_t address, const uint8_t data);
+		template<bool Debug> bool RunFrame(); //false if the debugger stopped it
+		template<bool Debug> void RunOpcode();
+		template<bool Debug> void Branch(const bool flag, const uint8_t op1);
+		template<bool Debug = false> void CpuRead(const uint16_t address);
+		template<bool Debug = false> void CpuWrite(const uint16_t address, const uint8_t data);
 		void CpuTick();
-		void CpuOpDone();
+		template<bool Debug> void CpuOpDone();
+		void DebugAccess(const DebugSpace space, const uint16_t address, const uint8_t type);
+		void LogPrg(const uint16_t address, const uint8_t flags, const CdlAccess access);
+		const int32_t PrgRomOffset(const uint16_t address) const; //-1 below $8000 or for ram mapped there
+		const uint32_t ProfileLocation(const uint16_t address) const;
+		void LogEvent(const PpuEventType type, const uint16_t address, const uint8_t value);
+		template<bool Debug> void OamDma();
+		template<bool Debug> void DmcDma();
+		const uint8_t* DmaPage(const uint8_t page);
 		void PollInterrupts();
+		void ScheduleIrq(const IrqSource source, const uint32_t cycle);
+		void UpdateIrqs();
 
-		void DebugCpu(uint8_t opcode);
-		uint8_t DebugRead(uint16_t address);
+		void Serialize(State &state);
 
+		void MapperInit();
 		void Addons();
+		void CartRegisterRead();
+		void CartRegisterWrite();
+		uint8_t* PrgBank8(const uint16_t bank);
+
 		void MMC1Registers();
+		void MMC2Registers();
 		void MMC3Registers();
 		bool MMC3Interrupt();
+		void MMC5Registers();
+		void MMC5Read();
+		void MMC5PrgUpdate();
+		void MMC5ChrUpdate();
+		void MMC5NametableUpdate(const uint8_t data);
+		void MMC5SplitUpdate();
+		bool MMC5Interrupt();
+		const uint32_t MMC5NextIrq() const;
 		void VRC4Registers();
-		bool VRC4Interrupt();
+		void VRC6Registers();
+		void VrcIrqControl();
+		void VrcIrqAcknowledge();
+		bool VrcInterrupt();
+		void VrcIrqClock(const uint32_t cycle);
+		const uint32_t VrcIrqNext() const;
+		void FME7Registers();
+		bool FME7Interrupt();
+		void FME7Clock(const uint32_t cycle);
+		void N163Registers();
+		void N163Read();
+		void N163ChrUpdate(const uint8_t reg);
+		bool N163Interrupt();
+		void N163Clock(const uint32_t cycle);
+
+		std::array<uint32_t, 5> romSha1;
+		size_t stateSize = 0;
+		std::vector<uint8_t> runAheadState;
+		Trace *trace = nullptr;
+		Debugger *debugger = nullptr;
+		CodeLogger *codeLogger = nullptr;
+		Profiler *profiler = nullptr;
+		EventLog *eventLog = nullptr;
+		uint16_t instructionPC = 0; //for the debugger, PC moves during the instruction
+		bool loaded = false;
+		bool jammed = false;
 
 		uint32_t cycleCount = 0;
 
-		uint16_t PC;
+		uint16_t PC = 0;
 		uint8_t rA = 0, rX = 0, rY = 0, rS = 0;
 		std::bitset<8> rP; //0:C | 1:Z | 2:I | 3:D | 4:B | 5:1 | 6:V | 7:N
 
-		uint16_t addressBus;
-		uint16_t dmaAddress;
-		uint8_t dataBus;
-		uint8_t controller_reg, controller_reg2;
+		uint16_t addressBus = 0;
+		uint16_t dmaAddress = 0;
+		uint8_t dataBus = 0;
+		InputPorts ports;
 
-		std::array<uint8_t, 0x800> cpuRam;
+		std::array<uint8_t, 0x800> cpuRam{};
 		std::vector<uint8_t> prgRom;
 		std::array<uint8_t*, 4> pPrgBank;
 
-		std::vector<uint8_t> prgRam;
+		SaveFile prgRam;
+		uint16_t saveSyncFrames = 0;
 		std::array<uint8_t*, 4> pPrgRamBank;
-
-		bool readJoy1 = false;
+		bool prgRamEnable = true;
+		bool prgRamWritable = true;
 
 		bool nmi = false;
 		std::array<bool, 3> nmiPending{};
 		std::array<bool, 3> irqPending{};
 
+		IrqScheduler irqScheduler;
+
 		bool dmaPending = false;
 		bool dmcDmaActive = false;
-		bool rw;
+		bool rw = false;
 
 		Type type;
-		uint8_t tempData;
+		uint8_t tempData = 0;
 
 		VRC4 vrc4;
+		VrcIrq vrcIrq;
 		MMC1 mmc1;
 		MMC3 mmc3;
+		MMC5 mmc5;
+		FME7 fme7;
+		N163 n163;
 };
@@ -1,17 +1,43 @@
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 
 #include "ppu.hpp"
 
 
+//every byte with its bits reversed, for the flipped rows of the chr cache
+static const std::array<uint8_t, 256> reversedBits = []
+{
+	std::array<uint8_t, 256> table{};
+	for(uint16_t x = 0; x < 256; ++x)
+	{
+		for(uint8_t bit = 0; bit < 8; ++bit)
+		{
+			table[x] |= ((x >> bit) & 1) << (7 - bit);
+		}
+	}
+	return table;
+}();
+
+
 Ppu::Ppu()
 {
+	ClearPadding(chrLatch);
 	oam.fill(0xFF);
+	BuildPaletteLut();
+	MaskWrite(0);
 }
 
 
 void Ppu::CtrlWrite(uint8_t dataBus) //2000
 {
+	if(oamEvalBulk && ((ppuCtrl ^ dataBus) & 0b00100000)) //sprite height changes the rest of the evaluation
+	{
+		OamEvalCatchUp();
+	}
 	ppuCtrl = dataBus;
 	ppuAddressLatch &= 0x73FF;
 	ppuAddressLatch |= (dataBus & 0b11) << 10;
@@ -21,15 +47,19 @@ void Ppu::CtrlWrite(uint8_t dataBus) //2000
 void Ppu::MaskWrite(uint8_t dataBus) //2001
 {
 	// bg & spr masks take 1 cycle to apply?
+	if(oamEvalBulk && !(dataBus & 0b00011000)) //evaluation stops where it is
+	{
+		OamEvalCatchUp();
+	}
 	ppuMask = dataBus;
 
 	grayscaleMask = (dataBus & 1) ? 0x30: 0xFF;
 
-	//crude implementation of color desaturation, actually attenuates signal by ~25% or something
-	emphasisMask = 0xFFFFFFFF;
-	if(dataBus & 0b00100000) emphasisMask &= 0xFFC0C0FF; //red
-	if(dataBus & 0b01000000) emphasisMask &= 0xFFC0FFC0; //green
-	if(dataBus & 0b10000000) emphasisMask &= 0xFFFFC0C0; //blue
+	const uint32_t *emphasis = &paletteLut[(dataBus >> 5) << 6];
+	for(uint8_t x = 0; x < 64; ++x)
+	{
+		outputPalette[x] = emphasis[x & grayscaleMask];
+	}
 }
 
 
@@ -76,10 +106,23 @@ void Ppu::OamDataWrite(uint8_t dataBus) //2004
 	// todo:
 	// Writes to OAMDATA during rendering (on the pre-render line and the visible lines 0-239, provided either sprite or
 	// background rendering is enabled) do not modify values in OAM, but do perform a glitchy increment of OAMADDR.
+	if(oamEvalBulk)
+	{
+		OamEvalCatchUp();
+	}
 	oam[oamAddr++] = dataBus;
 }
 
 
+void Ppu::OamDma(const uint8_t *page)
+{
+	//starts at oamAddr and wraps back to it
+	const uint16_t split = 256 - oamAddr;
+	std::copy_n(page, split, oam.begin() + oamAddr);
+	std::copy_n(page + split, oamAddr, oam.begin());
+}
+
+
 void Ppu::ScrollWrite(uint8_t dataBus) //2005
 {
 	if(!wToggle)
@@ -162,11 +205,13 @@ void Ppu::DataWrite(uint8_t dataBus) //2007
 			if(isChrRam == 1)
 			{
 				pPattern[ppuAddress >> 10][ppuAddress & 0x3FF] = dataBus;
+				DecodeChrRow(&pPattern[ppuAddress >> 10][ppuAddress & 0x3FF]);
 			}
 		}
 		else if(ppuAddress < 0x3F00)
 		{
 			pNametable[(ppuAddress >> 10) & 0b11][ppuAddress & 0x3FF] = dataBus;
+			DecodeChrRow(&pNametable[(ppuAddress >> 10) & 0b11][ppuAddress & 0x3FF]); //n163 nametables and tiles share memory
 		}
 		else
 		{
@@ -206,6 +251,7 @@ void Ppu::Tick()
 			oddFrame = !oddFrame;
 			renderFrame = true;
 			renderPos = 0;
+			skipRender = false; //the cpu overshoots into the next frame, those dots belong to whoever shows it
 		}
 		return; //idle at dot 0
 	}
@@ -223,6 +269,10 @@ void Ppu::Tick()
 	{
 		ppuStatus |= nmiFlag; //VBL nmi
 		nmiFlag = 0x80; //restore flag if it was prevented from getting set
+		if(snapshot)
+		{
+			TakeSnapshot();
+		}
 	}
 	else if(scanlineV == 261) //prerender scanline
 	{
@@ -235,6 +285,8 @@ void Ppu::Tick()
 		{
 			ppuAddress &= 0x41F;
 			ppuAddress |= ppuAddressLatch & 0x7BE0;
+			frameScroll = ppuAddress;
+			frameFineX = fineX;
 		}
 
 		if(ppuMask & 0b00011000)
@@ -258,7 +310,20 @@ void Ppu::Tick()
 
 void Ppu::VisibleScanlines()
 {
-	if(scanlineH <= 256)
+	if(scanlineH <= 256 && skipRender) //no pixel, only what's visible to the cpu: sprite 0 hit
+	{
+		++renderPos;
+		if(sprite0OnCurrent && !spriteXpos[0] && (ppuMask & 0b00011000) == 0b00011000 && scanlineH != 256 && !(scanlineH <= 8 && (ppuMask & 0b00000110) != 0b00000110))
+		{
+			const bool opaqueSprite0 = spriteBitmap[0] & 0xC000;
+			const bool opaqueBg = (bgPixels >> (30 - fineX * 2)) & 0b11;
+			if(opaqueSprite0 && opaqueBg)
+			{
+				ppuStatus = 0b01000000; //sprite 0 hit
+			}
+		}
+	}
+	else if(scanlineH <= 256)
 	{
 		uint8_t spritePixel = 0;
 		bool spritePriority; //false puts sprite in front of BG
@@ -271,8 +336,7 @@ void Ppu::VisibleScanlines()
 				{
 					if(!(scanlineH <= 8 && !(ppuMask & 0b00000100)))
 					{
-						spritePixel = spriteBitmapLow[x] >> 7;
-						spritePixel |= (spriteBitmapHigh[x] >> 6) & 0b10;
+						spritePixel = spriteBitmap[x] >> 14;
 						if(spritePixel)
 						{
 							spritePixel |= (spriteAttribute[x] & 0b11) << 2;
@@ -291,8 +355,7 @@ void Ppu::VisibleScanlines()
 		uint8_t bgPixel = 0;
 		if(ppuMask & 0b00001000 && !(scanlineH <= 8 && !(ppuMask & 0b00000010)))
 		{
-			bgPixel = (bgLow >> (15 - fineX)) & 1;
-			bgPixel |= (bgHigh >> (14 - fineX)) & 2;
+			bgPixel = (bgPixels >> (30 - fineX * 2)) & 0b11;
 
 			if(bgPixel)
 			{
@@ -321,7 +384,18 @@ void Ppu::VisibleScanlines()
 			}
 		}
 
-		render[renderPos++] = palette[pIndex & grayscaleMask] & emphasisMask;
+		if(pixelFormat == Rgba)
+		{
+			render[renderPos++] = outputPalette[pIndex];
+		}
+		else
+		{
+			if(scanlineH == 1)
+			{
+				lineEmphasis[scanlineV] = ppuMask >> 5;
+			}
+			renderIndexed[renderPos++] = pIndex & grayscaleMask;
+		}
 	}
 }
 
@@ -343,12 +417,19 @@ void Ppu::RenderFetches() //things done during visible and prerender scanlines
 			case 1: //NT
 				if(scanlineH != 1 && scanlineH != 321) 
 				{
-					bgLow |= bgLowLatch;
-					bgHigh |= bgHighLatch;
+					bgPixels |= bgLatch;
 					attribute |= (attributeLatch & 0b11) * 0x5555; //2-bit splat
 				}
 				ppuAddressBus = (ppuAddress & 0x0FFF) | 0x2000;
 				nametableA = pNametable[(ppuAddress >> 10) & 0b11][ppuAddress & 0x3FF];
+				if(exAttribute)
+				{
+					exAttributeLatch = exAttribute[ppuAddress & 0x3FF];
+				}
+				if(split)
+				{
+					SplitFetch();
+				}
 			break;
 
 			case 3: //AT
@@ -359,6 +440,14 @@ void Ppu::RenderFetches() //things done during visible and prerender scanlines
 
 					attributeLatch = pNametable[(ppuAddressBus >> 10) & 0b11][ppuAddressBus & 0x3FF];
 					attributeLatch >>= (((ppuAddress >> 1) & 1) | ((ppuAddress >> 5) & 0b10)) * 2;
+					if(exAttribute) //mmc5 extended attributes give every tile its own palette
+					{
+						attributeLatch = exAttributeLatch >> 6;
+					}
+					if(splitTile)
+					{
+						attributeLatch = splitAttribute;
+					}
 				}
 				else
 				{
@@ -367,36 +456,57 @@ void Ppu::RenderFetches() //things done during visible and prerender scanlines
 				}
 			break;
 
+			//each plane takes its half of the decoded row, the bank can change between the two fetches
 			case 5: //low
 				ppuAddressBus = (nametableA << 4) + (ppuAddress >> 12) | ((ppuCtrl & 0x10) << 8);
-				bgLowLatch = pPattern[(ppuAddressBus >> 10) & 7][ppuAddressBus & 0x3FF];
+				if(splitTile)
+				{
+					bgLatch = (bgLatch & 0xAAAA) | (patternDecoded[(splitBank << 12 | nametableA << 4 | (splitY & 7)) % pattern.size()] & 0x5555);
+				}
+				else if(!exAttribute)
+				{
+					bgLatch = (bgLatch & 0xAAAA) | (pDecoded[(ppuAddressBus >> 10) & 7][ppuAddressBus & 0x3FF] & 0x5555);
+				}
+				else //and its own 4kb chr bank
+				{
+					bgLatch = (bgLatch & 0xAAAA) | (patternDecoded[(((exAttributeLatch & 0x3F) | exAttributeHigh) << 12 | (ppuAddressBus & 0x0FFF)) % pattern.size()] & 0x5555);
+				}
 			break;
 
 			case 7: //high
-				bgHighLatch = pPattern[(ppuAddressBus >> 10) & 7][ppuAddressBus + 8 & 0x3FF];
+				if(splitTile)
+				{
+					bgLatch = (bgLatch & 0x5555) | (patternDecoded[(splitBank << 12 | nametableA << 4 | (splitY & 7)) % pattern.size()] & 0xAAAA);
+				}
+				else if(!exAttribute)
+				{
+					bgLatch = (bgLatch & 0x5555) | (pDecoded[(ppuAddressBus >> 10) & 7][ppuAddressBus & 0x3FF] & 0xAAAA);
+				}
+				else
+				{
+					bgLatch = (bgLatch & 0x5555) | (patternDecoded[(((exAttributeLatch & 0x3F) | exAttributeHigh) << 12 | (ppuAddressBus & 0x0FFF)) % pattern.size()] & 0xAAAA);
+				}
+
+				if(chrLatch.enabled)
+				{
+					ChrLatchUpdate(ppuAddressBus + 8);
+				}
 			break;
 		}
 
 		if(scanlineH <= 256)
 		{
-			for(uint8_t x = 0; x < 8; ++x)
+			for(uint8_t x = 0; x < 8; ++x) //no branches, the compiler does all 8 at once
 			{
-				if(spriteXpos[x])
-				{
-					--spriteXpos[x];
-				}
-				else
-				{
-					spriteBitmapLow[x] <<= 1;
-					spriteBitmapHigh[x] <<= 1;
-				}
+				const bool waiting = spriteXpos[x];
+				spriteXpos[x] -= waiting;
+				spriteBitmap[x] = waiting ? spriteBitmap[x] : spriteBitmap[x] << 2;
 			}
 		}
 
 		if(scanlineH <= 336)
 		{
-			bgLow <<= 1;
-			bgHigh <<= 1;
+			bgPixels <<= 2;
 			attribute <<= 2;
 		}
 	}
@@ -443,24 +553,23 @@ void Ppu::RenderFetches() //things done during visible and prerender scanlines
 				}
 				}
 
-				spriteBitmapLow[spriteIndex] = pPattern[(ppuAddressBus >> 10) & 7][ppuAddressBus & 0x3FF];
-				if(spriteAttribute[spriteIndex] & 0b01000000) //flip H
-				{
-					ReverseBits(spriteBitmapLow[spriteIndex]);
-				}
+				//flip H is the cache's flipped copy of the row
+				spriteBitmap[spriteIndex] &= 0xAAAA;
+				spriteBitmap[spriteIndex] |= (splitSpritePattern ? pSpriteDecoded : pDecoded)[(ppuAddressBus >> 10) & 7][(ppuAddressBus & 0x3FF) | (spriteAttribute[spriteIndex] & 0b01000000) >> 3] & 0x5555;
 			break;
 
 			case 7:
-				spriteBitmapHigh[spriteIndex] = pPattern[(ppuAddressBus >> 10) & 7][(ppuAddressBus | 8) & 0x3FF];
-				if(spriteAttribute[spriteIndex] & 0b01000000) //flip H
+				spriteBitmap[spriteIndex] &= 0x5555;
+				spriteBitmap[spriteIndex] |= (splitSpritePattern ? pSpriteDecoded : pDecoded)[(ppuAddressBus >> 10) & 7][(ppuAddressBus & 0x3FF) | (spriteAttribute[spriteIndex] & 0b01000000) >> 3] & 0xAAAA;
+
+				if(chrLatch.enabled)
 				{
-					ReverseBits(spriteBitmapHigh[spriteIndex]);
+					ChrLatchUpdate(ppuAddressBus | 8);
 				}
 
 				if(uint16_t(scanlineV - oam2[spriteIndex * 4]) >= 8 + ((ppuCtrl & 0b00100000) >> 2)) //prevent copying if Y coord is out of range
 				{
-					spriteBitmapLow[spriteIndex] = 0;
-					spriteBitmapHigh[spriteIndex] = 0;
+					spriteBitmap[spriteIndex] = 0;
 				}
 
 				++spriteIndex &= 0b0111;
@@ -480,55 +589,18 @@ void Ppu::OamScan() //dots 1-256
 		}
 		else if(scanlineH <= 256)
 		{
-			if(oamEvalPattern == 0) //search for sprites in range
+			if(scanlineH == 66 && !(oam2Index | oamEvalPattern | oamSpritenum | oamDiagonal)) //not after rendering was cut mid-evaluation
 			{
-				oam2[oam2Index] = oam[oamSpritenum]; //oam should start searching at oam[oamAddr]
-
-				const uint8_t spriteHeight = 8 + ((ppuCtrl & 0b00100000) >> 2);
-				if(uint16_t(scanlineV - oam[oamSpritenum]) < spriteHeight) //if current scanline is on a sprite
-				{
-					++oamEvalPattern;
-					++oam2Index;
-					if(!oamSpritenum)
-					{
-						sprite0OnNext = true;
-					}
-				}
-				else
-				{
-					if(!oamSpritenum)
-					{
-						sprite0OnNext = false;
-					}
-					OamUpdateIndex();
-				}
+				OamEvalLine();
 			}
-			else if(oamEvalPattern <= 3)
+
+			if(!oamEvalBulk)
 			{
-				oam2[oam2Index++] = oam[oamSpritenum + oamEvalPattern++];
-				if(oamEvalPattern > 3)
-				{
-					OamUpdateIndex();						
-				}
+				OamEvalStep();
 			}
-			else if(oamEvalPattern == 4) //entire oam searched
+			else if(scanlineH == overflowDot)
 			{
-				// oamSpritenum += 4; //do nothing
-			}
-			else //search for overflow
-			{
-				if(scanlineV >= oam[oamSpritenum + oamDiagonal] && scanlineV < oam[oamSpritenum + oamDiagonal] + 8 + ((ppuCtrl & 0b00100000) >> 2))
-				{
-					ppuStatus |= 0b00100000;
-					oamEvalPattern = 4;
-				}
-				oamSpritenum += 4;
-				++oamDiagonal &= 0b11; //HW bug: search oam "diagonally" by adding 0-3 per search
-
-				if(oamSpritenum == 0) //stop searching
-				{
-					oamEvalPattern = 4;
-				}
+				ppuStatus |= 0b00100000;
 			}
 
 			if(scanlineH == 256)
@@ -537,12 +609,152 @@ void Ppu::OamScan() //dots 1-256
 				oamSpritenum = 0;
 				oamEvalPattern = 0;
 				oamDiagonal = 0;
+				oamEvalBulk = false;
 			}
 		}
 	}
 }
 
 
+void Ppu::OamEvalStep() //even dots 66-256
+{
+	if(oamEvalPattern == 0) //search for sprites in range
+	{
+		oam2[oam2Index] = oam[oamSpritenum]; //oam should start searching at oam[oamAddr]
+
+		const uint8_t spriteHeight = 8 + ((ppuCtrl & 0b00100000) >> 2);
+		if(uint16_t(scanlineV - oam[oamSpritenum]) < spriteHeight) //if current scanline is on a sprite
+		{
+			++oamEvalPattern;
+			++oam2Index;
+			if(!oamSpritenum)
+			{
+				sprite0OnNext = true;
+			}
+		}
+		else
+		{
+			if(!oamSpritenum)
+			{
+				sprite0OnNext = false;
+			}
+			OamUpdateIndex();
+		}
+	}
+	else if(oamEvalPattern <= 3)
+	{
+		oam2[oam2Index++] = oam[oamSpritenum + oamEvalPattern++];
+		if(oamEvalPattern > 3)
+		{
+			OamUpdateIndex();
+		}
+	}
+	else if(oamEvalPattern == 4) //entire oam searched
+	{
+		// oamSpritenum += 4; //do nothing
+	}
+	else //search for overflow
+	{
+		if(scanlineV >= oam[oamSpritenum + oamDiagonal] && scanlineV < oam[oamSpritenum + oamDiagonal] + 8 + ((ppuCtrl & 0b00100000) >> 2))
+		{
+			ppuStatus |= 0b00100000;
+			oamEvalPattern = 4;
+		}
+		oamSpritenum += 4;
+		++oamDiagonal &= 0b11; //HW bug: search oam "diagonally" by adding 0-3 per search
+
+		if(oamSpritenum == 0) //stop searching
+		{
+			oamEvalPattern = 4;
+		}
+	}
+}
+
+
+void Ppu::OamEvalLine() //everything OamEvalStep does on one line, oam2 is only read after dot 256
+{
+	const uint8_t spriteHeight = 8 + ((ppuCtrl & 0b00100000) >> 2);
+	uint64_t inRange = SpritesInRange(spriteHeight);
+	sprite0OnNext = inRange & 1;
+	overflowDot = 0;
+
+	uint8_t found = 0, last = 0;
+	const bool sprite63 = inRange >> 63;
+	while(inRange && found < 8)
+	{
+		last = __builtin_ctzll(inRange);
+		inRange &= inRange - 1;
+		std::copy_n(oam.begin() + last * 4, 4, oam2.begin() + found * 4);
+		++found;
+	}
+
+	if(found < 8)
+	{
+		if(!sprite63) //every miss writes its y to the next free slot
+		{
+			oam2[found * 4] = oam[252];
+		}
+	}
+	else
+	{
+		//one step per sprite and three per copy, so sprite n is checked for overflow on step n + 24
+		for(uint8_t n = last + 1, diagonal = 0; n < 64; ++n, ++diagonal &= 0b11)
+		{
+			const uint8_t y = oam[n * 4 + diagonal];
+			if(scanlineV >= y && scanlineV < y + spriteHeight)
+			{
+				overflowDot = 66 + (n + 24) * 2;
+				break;
+			}
+		}
+	}
+	oamEvalBulk = true;
+}
+
+
+void Ppu::OamEvalCatchUp() //something the evaluation reads is about to change, redo this line's steps so far one by one
+{
+	oamEvalBulk = false;
+	oam2.fill(0xFF);
+	for(uint16_t dot = 66; dot <= scanlineH; dot += 2)
+	{
+		OamEvalStep();
+	}
+}
+
+
+const uint64_t Ppu::SpritesInRange(const uint8_t height) const //bit n for sprite n on the current scanline
+{
+	uint64_t inRange = 0;
+	#ifdef __SSE2__
+	//16 sprites at a time, their y bytes packed together. in range is y <= scanline && scanline - y < height
+	const __m128i line = _mm_set1_epi8(scanlineV);
+	const __m128i lastRow = _mm_set1_epi8(height - 1);
+	const __m128i yMask = _mm_set1_epi32(0xFF);
+	for(uint8_t x = 0; x < 4; ++x)
+	{
+		const __m128i *sprites = reinterpret_cast<const __m128i*>(oam.data() + x * 64);
+		const __m128i y0 = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(sprites), yMask), _mm_and_si128(_mm_loadu_si128(sprites + 1), yMask));
+		const __m128i y1 = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(sprites + 2), yMask), _mm_and_si128(_mm_loadu_si128(sprites + 3), yMask));
+		const __m128i y = _mm_packus_epi16(y0, y1);
+		const __m128i row = _mm_sub_epi8(line, y);
+		const __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(y, line), line);
+		const __m128i within = _mm_cmpeq_epi8(_mm_min_epu8(row, lastRow), row);
+		inRange |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_and_si128(above, within)))) << (x * 16);
+	}
+	#else
+	for(uint8_t x = 0; x < 64; ++x)
+	{
+		if(uint16_t(scanlineV - oam[x * 4]) < height)
+		{
+			inRange |= uint64_t(1) << x;
+		}
+	}
+	#endif
+	return inRange;
+}
+
+
 void Ppu::OamUpdateIndex()
 {
 	oamSpritenum += 4;
@@ -605,11 +817,96 @@ const bool Ppu::PollNmi() const
 }
 
 
-void Ppu::ReverseBits(uint8_t &b) const
+const bool Ppu::RenderingEnabled() const
+{
+	return ppuMask & 0b00011000;
+}
+
+
+void Ppu::DecodeTileRow(const uint8_t *chr, uint16_t *decoded, const size_t offset) const //offset of the low plane byte
+{
+	auto spread = [](uint16_t b) //abcdefgh -> 0a0b0c0d0e0f0g0h
+	{
+		b = (b | b << 4) & 0x0F0F;
+		b = (b | b << 2) & 0x3333;
+		return uint16_t((b | b << 1) & 0x5555);
+	};
+
+	const uint8_t low = chr[offset], high = chr[offset + 8];
+	decoded[offset] = spread(low) | spread(high) << 1;
+	decoded[offset + 8] = spread(reversedBits[low]) | spread(reversedBits[high]) << 1;
+}
+
+
+void Ppu::DecodeChr()
+{
+	patternDecoded.resize(pattern.size());
+	DecodeRows(pattern.data(), patternDecoded.data(), pattern.size());
+	DecodeRows(nametable.data(), nametableDecoded.data(), nametable.size());
+}
+
+
+void Ppu::DecodeRows(const uint8_t *chr, uint16_t *decoded, const size_t size) const
+{
+	for(size_t x = 0; x < size; ++x)
+	{
+		if(!(x & 8))
+		{
+			DecodeTileRow(chr, decoded, x);
+		}
+	}
+}
+
+
+void Ppu::DecodeChrRow(const uint8_t *chr) //after a write, only the row it's in changes
 {
-	b = b >> 4 | b << 4;
-	b = (b & 0b11001100) >> 2 | (b & 0b00110011) << 2;
-	b = (b & 0b10101010) >> 1 | (b & 0b01010101) << 1;
+	if(chr >= pattern.data() && chr < pattern.data() + pattern.size())
+	{
+		DecodeTileRow(pattern.data(), patternDecoded.data(), (chr - pattern.data()) & ~size_t(8));
+	}
+	else if(chr >= nametable.data() && chr < nametable.data() + nametable.size())
+	{
+		DecodeTileRow(nametable.data(), nametableDecoded.data(), (chr - nametable.data()) & ~size_t(8));
+	}
+}
+
+
+uint16_t* Ppu::DecodedPtr(const uint8_t *chr)
+{
+	if(chr >= pattern.data() && chr < pattern.data() + pattern.size())
+	{
+		return patternDecoded.data() + (chr - pattern.data());
+	}
+	else if(chr >= nametable.data() && chr < nametable.data() + nametable.size())
+	{
+		return nametableDecoded.data() + (chr - nametable.data());
+	}
+	return nullptr;
+}
+
+
+void Ppu::UpdateDecodedBanks()
+{
+	for(int x = 0; x < 8; x++)
+	{
+		pDecoded[x] = DecodedPtr(pPattern[x]);
+		pSpriteDecoded[x] = DecodedPtr(pSpritePattern[x]);
+	}
+}
+
+
+void Ppu::ChrLatchUpdate(const uint16_t address) //called after the high plane fetch, the new bank applies to the next tile
+{
+	const uint16_t tile = address & 0x0FF0;
+	if(tile == 0x0FD0 || tile == 0x0FE0)
+	{
+		const bool table = address & 0x1000;
+		if(table || chrLatch.mmc4 || (address & 0x0F) == 0x08) //mmc2 only reacts to $0FD8 / $0FE8 in the low table
+		{
+			chrLatch.fe[table] = tile == 0x0FE0;
+			SetPatternBanks4(table, chrLatch.bank[(table << 1) | chrLatch.fe[table]]);
+		}
+	}
 }
 
 
@@ -619,6 +916,143 @@ const uint32_t* const Ppu::GetPixelPtr() const
 }
 
 
+const uint8_t* const Ppu::GetIndexPtr() const
+{
+	return renderIndexed.data();
+}
+
+
+const uint8_t* const Ppu::GetEmphasisPtr() const
+{
+	return lineEmphasis.data();
+}
+
+
+const uint32_t* const Ppu::GetPaletteLut() const
+{
+	return paletteLut.data();
+}
+
+
+void Ppu::SetPixelFormat(const PixelFormat format)
+{
+	pixelFormat = format;
+}
+
+
+void Ppu::Serialize(State &state)
+{
+	if(oamEvalBulk) //states only know the per dot evaluation
+	{
+		OamEvalCatchUp();
+	}
+
+	state.AddRegion(pattern.data(), pattern.size());
+	state.AddRegion(nametable.data(), nametable.size());
+
+	if(isChrRam)
+	{
+		state.Block(pattern.data(), pattern.size());
+	}
+	state.Data(nametable);
+	state.Data(paletteIndices);
+	state.Data(oam);
+	state.Data(oam2);
+	for(auto &p : pPattern)
+	{
+		state.Pointer(p);
+	}
+	for(auto &p : pSpritePattern)
+	{
+		state.Pointer(p);
+	}
+	for(auto &p : pNametable)
+	{
+		state.Pointer(p);
+	}
+	state.Data(splitSpritePattern);
+
+	state.Data(renderPos);
+	state.Data(ppuCtrl);
+	state.Data(ppuMask);
+	state.Data(ppuStatus);
+	state.Data(oamAddr);
+	state.Data(scanlineH);
+	state.Data(scanlineV);
+	state.Data(ppuAddress);
+	state.Data(ppuAddressLatch);
+	state.Data(ppuAddressBus);
+	state.Data(nametableA);
+	state.Data(attribute);
+	state.Data(attributeLatch);
+	state.Data(bgPixels);
+	state.Data(bgLatch);
+	state.Data(wToggle);
+	state.Data(oddFrame);
+	state.Data(fineX);
+	state.Data(ppuDataLatch);
+	state.Data(oam2Index);
+	state.Data(oamEvalPattern);
+	state.Data(oamSpritenum);
+	state.Data(oamDiagonal);
+	state.Data(suppressNmi);
+	state.Data(nmiFlag);
+	state.Data(spriteBitmap);
+	state.Data(spriteAttribute);
+	state.Data(spriteXpos);
+	state.Data(spriteIndex);
+	state.Data(sprite0OnNext);
+	state.Data(sprite0OnCurrent);
+	state.Data(chrLatch);
+	state.Pointer(exAttribute);
+	state.Data(exAttributeHigh);
+	state.Data(exAttributeLatch);
+	state.Pointer(split);
+	state.Data(splitControl);
+	state.Data(splitScroll);
+	state.Data(splitY);
+	state.Data(splitAttribute);
+	state.Data(splitBank);
+	state.Data(splitTile);
+	state.Data(TToVDelay);
+	state.Data(renderFrame);
+
+	if(state.Loading())
+	{
+		MaskWrite(ppuMask); //output palette and grayscale follow from $2001
+		if(isChrRam) //chr rom isn't in states and never changes, it was decoded when the cart was loaded
+		{
+			DecodeRows(pattern.data(), patternDecoded.data(), pattern.size());
+		}
+		DecodeRows(nametable.data(), nametableDecoded.data(), nametable.size());
+		UpdateDecodedBanks();
+	}
+}
+
+
+void Ppu::BuildPaletteLut()
+{
+	//each emphasis bit attenuates the two other channels by roughly a quarter
+	for(uint8_t emphasis = 0; emphasis < 8; ++emphasis)
+	{
+		for(uint8_t x = 0; x < 64; ++x)
+		{
+			uint32_t color = palette[x] & 0xFF000000;
+			for(uint8_t channel = 0; channel < 3; ++channel) //r, g, b from the low byte up
+			{
+				uint32_t value = (palette[x] >> (channel * 8)) & 0xFF;
+				if(emphasis & ~(1 << channel) & 0b111)
+				{
+					value = value * 191 / 256;
+				}
+				color |= value << (channel * 8);
+			}
+			paletteLut[(emphasis << 6) | x] = color;
+		}
+	}
+}
+
+
 const uint16_t Ppu::GetScanlineH() const
 {
 	return scanlineH;
@@ -631,6 +1065,12 @@ const uint16_t Ppu::GetScanlineV() const
 }
 
 
+const uint16_t Ppu::GetVramAddress() const
+{
+	return ppuAddress & 0x3FFF;
+}
+
+
 void Ppu::SetNametableArrangement(const std::array<NametableOffset, 4> &offset)
 {
 	for(int x = 0; x < 4; x++)
@@ -640,9 +1080,99 @@ void Ppu::SetNametableArrangement(const std::array<NametableOffset, 4> &offset)
 }
 
 
+const uint32_t Ppu::DotsUntil(const uint16_t line, const uint16_t dot) const //ignores the odd frame skip, so never late
+{
+	const int32_t dots = (line - scanlineV) * 341 + dot - scanlineH;
+	return (dots > 0) ? dots : dots + 262 * 341;
+}
+
+
+const uint32_t Ppu::DotsUntilA12Change() const
+{
+	const bool renderLine = scanlineV < 240 || scanlineV == 261;
+	if(ppuAddressBus & 0x1000) //any nametable fetch takes it down, 8x8 sprites from $1000 keep it up until the one at 321
+	{
+		if(!renderLine)
+		{
+			return DotsUntil(261, 1);
+		}
+		return (scanlineH >= 257 && scanlineH < 321 && (ppuCtrl & 0b00101000) == 0b00001000) ? 321 - scanlineH : 0;
+	}
+
+	//only pattern fetches put A12 on the bus, nametable and attribute fetches are at $2xxx
+	if(ppuCtrl & 0b00010000) //background from $1000
+	{
+		return 0;
+	}
+	if(!(ppuCtrl & 0b00101000)) //8x8 sprites from $0000 too, it stays low
+	{
+		return 262 * 341;
+	}
+
+	//sprite rows are fetched at dots 261, 269 ... 317 of the visible and prerender lines
+	if(renderLine && scanlineH < 317)
+	{
+		return ((scanlineH < 261) ? 261 : 261 + ((scanlineH - 261) / 8 + 1) * 8) - scanlineH;
+	}
+	return DotsUntil((scanlineV >= 239 && scanlineV < 261) ? 261 : (scanlineV + 1) % 262, 261);
+}
+
+
+const bool Ppu::SensesLight(const int16_t x, const int16_t y) const
+{
+	//the zapper's photodiode sees a pixel for the 20 or so lines after the beam drew it
+	if(x < 0 || x >= 256 || y < 0 || y >= 240 || scanlineV < y || scanlineV >= y + 20 || (scanlineV == y && scanlineH <= x))
+	{
+		return false;
+	}
+
+	const uint32_t color = (pixelFormat == Rgba) ? render[y * 256 + x] : palette[renderIndexed[y * 256 + x]];
+	return (color & 0xFF) + ((color >> 8) & 0xFF) + ((color >> 16) & 0xFF) >= 0x180;
+}
+
+
+void Ppu::SetNametable(const uint8_t quadrant, const NametableOffset offset)
+{
+	pNametable[quadrant] = nametable.data() + offset;
+}
+
+
+void Ppu::SetNametable(const uint8_t quadrant, uint8_t *page) //1kb of cart memory
+{
+	pNametable[quadrant] = page;
+}
+
+
+void Ppu::SetNametableChr(const uint8_t quadrant, const uint16_t bank)
+{
+	pNametable[quadrant] = &pattern[(bank << 10) % pattern.size()];
+}
+
+
 void Ppu::SetPatternBanks1(const uint8_t bank, const uint16_t offset)
 {
-	pPattern[bank] = &pattern[offset << 10];
+	pPattern[bank] = &pattern[(offset << 10) % pattern.size()];
+	pDecoded[bank] = DecodedPtr(pPattern[bank]);
+}
+
+
+void Ppu::SetPatternNametable(const uint8_t bank, const NametableOffset offset)
+{
+	pPattern[bank] = nametable.data() + offset;
+	pDecoded[bank] = DecodedPtr(pPattern[bank]);
+}
+
+
+void Ppu::SetSpritePatternBanks1(const uint8_t bank, const uint16_t offset)
+{
+	pSpritePattern[bank] = &pattern[(offset << 10) % pattern.size()];
+	pSpriteDecoded[bank] = DecodedPtr(pSpritePattern[bank]);
+}
+
+
+void Ppu::SplitSpritePattern(const bool split)
+{
+	splitSpritePattern = split;
 }
 
 
@@ -651,6 +1181,7 @@ void Ppu::SetPatternBanks2(const uint8_t bank, const uint8_t offset)
 	for(int x = 0; x < 2; x++)
 	{
 		pPattern[(bank << 1) + x] = &pattern[(offset << 11) + 0x400 * x];
+		pDecoded[(bank << 1) + x] = DecodedPtr(pPattern[(bank << 1) + x]);
 	}
 }
 
@@ -660,6 +1191,7 @@ void Ppu::SetPatternBanks4(const bool bank, const uint8_t offset)
 	for(int x = 0; x < 4; x++)
 	{
 		pPattern[(bank << 2) + x] = &pattern[(offset << 12) + 0x400 * x];
+		pDecoded[(bank << 2) + x] = DecodedPtr(pPattern[(bank << 2) + x]);
 	}
 }
 
@@ -669,6 +1201,7 @@ void Ppu::SetPatternBanks8(const uint8_t offset)
 	for(int x = 0; x < 8; x++)
 	{
 		pPattern[x] = &pattern[(offset << 13) + 0x400 * x];
+		pDecoded[x] = DecodedPtr(pPattern[x]);
 	}
 }
 
@@ -680,6 +1213,152 @@ void Ppu::SetPattern(std::vector<uint8_t> &chr) //better name for this function?
 	{
 		pPattern[x] = &pattern[0x400 * x];
 	}
+	DecodeChr();
+	UpdateDecodedBanks();
+}
+
+
+void Ppu::SetSnapshot(PpuSnapshot *target)
+{
+	snapshot = target;
+}
+
+
+void Ppu::TakeSnapshot()
+{
+	for(uint8_t x = 0; x < 4; ++x)
+	{
+		std::copy(pNametable[x], pNametable[x] + 0x400, snapshot->nametables.begin() + x * 0x400);
+	}
+	for(uint16_t address = 0; address < 0x2000; address += 16) //only the unflipped rows
+	{
+		std::copy(pDecoded[address >> 10] + (address & 0x3FF), pDecoded[address >> 10] + (address & 0x3FF) + 8, snapshot->tiles.begin() + address / 2);
+	}
+	snapshot->palette = paletteIndices;
+	snapshot->oam = oam;
+	snapshot->colors = outputPalette;
+	snapshot->scroll = frameScroll;
+	snapshot->fineX = frameFineX;
+	snapshot->ctrl = ppuCtrl;
+	++snapshot->frame;
+}
+
+
+const uint16_t Ppu::ChrRow(const uint16_t address, const bool flip) const
+{
+	return pDecoded[(address >> 10) & 7][(address & 0x3F7) | flip << 3];
+}
+
+
+const uint8_t Ppu::DebugRead(const uint16_t address) const
+{
+	const uint16_t a = address & 0x3FFF;
+	if(a < 0x2000)
+	{
+		return pPattern[a >> 10][a & 0x3FF];
+	}
+	else if(a < 0x3F00)
+	{
+		return pNametable[(a >> 10) & 0b11][a & 0x3FF];
+	}
+	return paletteIndices[a & 0x1F];
+}
+
+
+const size_t Ppu::ChrRomSize() const
+{
+	return isChrRam ? 0 : pattern.size();
+}
+
+
+const int32_t Ppu::ChrRomOffset(const uint16_t address) const
+{
+	const uint8_t *byte = pPattern[(address >> 10) & 7] + (address & 0x3FF);
+	if(isChrRam || address >= 0x2000 || byte < pattern.data() || byte >= pattern.data() + pattern.size())
+	{
+		return -1;
+	}
+	return byte - pattern.data();
+}
+
+
+void Ppu::DebugWrite(const uint16_t address, const uint8_t data)
+{
+	const uint16_t a = address & 0x3FFF;
+	if(a < 0x2000)
+	{
+		pPattern[a >> 10][a & 0x3FF] = data;
+		DecodeChrRow(&pPattern[a >> 10][a & 0x3FF]);
+	}
+	else if(a < 0x3F00)
+	{
+		pNametable[(a >> 10) & 0b11][a & 0x3FF] = data;
+		DecodeChrRow(&pNametable[(a >> 10) & 0b11][a & 0x3FF]);
+	}
+	else
+	{
+		paletteIndices[a & 0x1F] = data & 0x3F;
+		if(!(a & 0b11))
+		{
+			paletteIndices[(a & 0x1F) ^ 0x10] = data & 0x3F;
+		}
+	}
+}
+
+
+void Ppu::SetChrLatch(const bool mmc4)
+{
+	chrLatch.enabled = true;
+	chrLatch.mmc4 = mmc4;
+}
+
+
+void Ppu::SetChrLatchBank(const uint8_t reg, const uint8_t bank) //0: $0FD, 1: $0FE, 2: $1FD, 3: $1FE
+{
+	chrLatch.bank[reg] = (bank << 12) % pattern.size() >> 12;
+	const bool table = reg >> 1;
+	if(chrLatch.fe[table] == (reg & 1))
+	{
+		SetPatternBanks4(table, chrLatch.bank[reg]);
+	}
+}
+
+
+void Ppu::SetExAttribute(const uint8_t *exRam, const uint8_t chrHigh)
+{
+	exAttribute = exRam;
+	exAttributeHigh = chrHigh << 6;
+}
+
+
+void Ppu::SetVerticalSplit(const uint8_t *exRam, const uint8_t control, const uint8_t scroll, const uint8_t bank)
+{
+	split = exRam;
+	splitTile = splitTile && exRam;
+	splitControl = control;
+	splitScroll = scroll;
+	splitBank = bank;
+}
+
+
+void Ppu::SplitFetch()
+{
+	//the mmc5 counts the tiles of a line and swaps in its own nametable, attributes and 4kb chr bank left or right of a threshold.
+	//the split scrolls vertically on its own, fine x still comes from the ppu
+	const bool prefetch = scanlineH >= 321;
+	const uint8_t column = prefetch ? (scanlineH - 321) >> 3 : (scanlineH >> 3) + 2;
+	const uint8_t threshold = splitControl & 0x1F;
+	splitTile = (scanlineH <= 336) && ((splitControl & 0x40) ? column >= threshold : column < threshold);
+	if(!splitTile)
+	{
+		return;
+	}
+
+	const uint16_t line = prefetch ? ((scanlineV == 261) ? 0 : scanlineV + 1) : scanlineV;
+	splitY = (splitScroll < 240) ? (splitScroll + line) % 240 : (splitScroll + line) & 0xFF;
+	nametableA = split[(splitY >> 3) << 5 | (column & 31)];
+	splitAttribute = split[0x3C0 | (splitY >> 5) << 3 | (column & 31) >> 2];
+	splitAttribute >>= (((column >> 1) & 1) | ((splitY >> 3) & 0b10)) * 2;
 }
 
 
@@ -4,7 +4,32 @@
 #include <array>
 #include <vector>
 
+#include "state.hpp"
+
 enum NametableOffset : uint16_t {A = 0, B = 0x400, C = 0x800, D = 0xC00};
+enum PixelFormat : uint8_t {Rgba = 0, Indexed = 1};
+
+struct ChrLatch //mmc2/mmc4
+{
+	std::array<uint8_t, 4> bank{}; //4kb banks selected by $FD/$FE for each pattern table
+	std::array<bool, 2> fe{{true, true}};
+	bool enabled = false;
+	bool mmc4 = false;
+};
+
+//what the debug viewers draw from, copied at the start of vblank so they never touch the live ppu
+struct PpuSnapshot
+{
+	std::array<uint8_t, 0x1000> nametables{};  //the 4 quadrants as they're mapped
+	std::array<uint16_t, 0x1000> tiles{};      //both pattern tables as mapped, 8 decoded rows per tile
+	std::array<uint8_t, 32> palette{};
+	std::array<uint8_t, 64*4> oam{};
+	std::array<uint32_t, 64> colors{};         //rgba with the frame's emphasis
+	uint16_t scroll = 0; //v at the top of the frame
+	uint8_t fineX = 0;
+	uint8_t ctrl = 0;
+	uint32_t frame = 0;
+};
 
 class Ppu
 {
@@ -17,6 +42,7 @@ class Ppu
 		void OamAddrWrite(uint8_t dataBus); //2003
 		const uint8_t OamDataRead() const;  //2004
 		void OamDataWrite(uint8_t dataBus); //2004
+		void OamDma(const uint8_t *page);   //256 writes to 2004 at once
 		void ScrollWrite(uint8_t dataBus);  //2005
 		void AddrWrite(uint8_t dataBus);    //2006
 		uint8_t DataRead();                 //2007
@@ -25,22 +51,50 @@ class Ppu
 		void Tick();
 
 		const bool PollNmi() const;
+		const bool RenderingEnabled() const;
 
 		const bool RenderFrame();
 		const uint32_t* const GetPixelPtr() const;
+		const uint8_t* const GetIndexPtr() const;     //6 bit palette index per pixel
+		const uint8_t* const GetEmphasisPtr() const;  //emphasis bits per line, as in $2001 >> 5
+		const uint32_t* const GetPaletteLut() const;  //rgba for emphasis << 6 | index
+		void SetPixelFormat(const PixelFormat format);
 
 		const uint16_t GetScanlineH() const;
 		const uint16_t GetScanlineV() const;
+		const uint16_t GetVramAddress() const; //where the next $2007 access goes
+		const uint32_t DotsUntil(const uint16_t line, const uint16_t dot) const;
+		const uint32_t DotsUntilA12Change() const; //to the next fetch that can move A12 while rendering, 0 if the next few can
+		const bool SensesLight(const int16_t x, const int16_t y) const; //whether a zapper aimed there sees a bright pixel now
 
 		void SetNametableArrangement(const std::array<NametableOffset, 4> &offset);
+		void SetNametable(const uint8_t quadrant, const NametableOffset offset);
+		void SetNametable(const uint8_t quadrant, uint8_t *page);
+		void SetNametableChr(const uint8_t quadrant, const uint16_t bank);
 		void SetPatternBanks1(const uint8_t bank, const uint16_t offset);
 		void SetPatternBanks2(const uint8_t bank, const uint8_t offset);
 		void SetPatternBanks4(const bool bank, const uint8_t offset);
 		void SetPatternBanks8(const uint8_t offset);
+		void SetPatternNametable(const uint8_t bank, const NametableOffset offset);
+		void SetSpritePatternBanks1(const uint8_t bank, const uint16_t offset);
+		void SplitSpritePattern(const bool split);
+		void SetChrLatch(const bool mmc4);
+		void SetChrLatchBank(const uint8_t reg, const uint8_t bank);
+		void SetExAttribute(const uint8_t *exRam, const uint8_t chrHigh);
+		void SetVerticalSplit(const uint8_t *exRam, const uint8_t control, const uint8_t scroll, const uint8_t bank); //null exRam turns it off
 		void SetPattern(std::vector<uint8_t> &chr);
 		void SetChrType(bool type);
+		void SetSnapshot(PpuSnapshot *target); //filled every vblank, null stops it
+		const uint16_t ChrRow(const uint16_t address, const bool flip) const; //8 decoded pixels of a row, for viewers
+		const uint8_t DebugRead(const uint16_t address) const; //pattern tables, nametables and palette without side effects
+		void DebugWrite(const uint16_t address, const uint8_t data); //same, chr rom included
+		const size_t ChrRomSize() const;
+		const int32_t ChrRomOffset(const uint16_t address) const; //where a pattern address is in chr rom, -1 for chr ram or nametables
+
+		void Serialize(State &state);
 
 		bool renderFrame = false;
+		bool skipRender = false; //no pixel composition until the frame ends, sprite 0 hit still runs
 
 
 		bool GetA12();
@@ -49,14 +103,30 @@ class Ppu
 		void VisibleScanlines();
 		void RenderFetches();
 		void OamScan();
+		void OamEvalStep();
+		void OamEvalLine();
+		void OamEvalCatchUp();
+		const uint64_t SpritesInRange(const uint8_t height) const;
 		void OamUpdateIndex();
 
 		void YIncrement();
 		void CoarseXIncrement();
 
-		void ReverseBits(uint8_t &b) const;
+		void DecodeTileRow(const uint8_t *chr, uint16_t *decoded, const size_t offset) const;
+		void DecodeChr();
+		void DecodeRows(const uint8_t *chr, uint16_t *decoded, const size_t size) const;
+		void DecodeChrRow(const uint8_t *chr);
+		uint16_t* DecodedPtr(const uint8_t *chr);
+		void UpdateDecodedBanks();
+		void TakeSnapshot();
+		void BuildPaletteLut();
+		void ChrLatchUpdate(const uint16_t address);
+		void SplitFetch();
 
 		std::array<uint32_t, 256*240> render;
+		std::array<uint8_t, 256*240> renderIndexed;
+		std::array<uint8_t, 240> lineEmphasis{};
+		PixelFormat pixelFormat = Rgba;
 
 		const std::array<uint32_t, 64> palette //PVM Style D93 (FBX) http://www.firebrandx.com/nespalette.html
 		{{
@@ -69,18 +139,29 @@ class Ppu
 			0xFFFFFFFF, 0xFFFFEAD2, 0xFFFFE2E2, 0xFFFFD8E9, 0xFFFFD2F5, 0xFFEAD9F8, 0xFFB9DEFA, 0xFF9BE8F9,
 			0xFF8CF2F3, 0xFF91FAD3, 0xFFA8FCB8, 0xFFCAFAAE, 0xFFF3F3CA, 0xFFB8C0BE, 0xFF000000, 0xFF000000,
 		}};
+		std::array<uint32_t, 64*8> paletteLut;    //every emphasis combination, built once
+		std::array<uint32_t, 64> outputPalette;   //current emphasis and grayscale, rebuilt on $2001 writes
 
-		std::array<uint8_t*, 8> pPattern;
-		std::array<uint8_t*, 4> pNametable;
+		std::array<uint8_t*, 8> pPattern{};
+		std::array<uint8_t*, 8> pSpritePattern{}; //only used while split, mmc5 fetches 8x16 sprites from other banks
+		bool splitSpritePattern = false;
+		std::array<uint8_t*, 4> pNametable{};
 		std::vector<uint8_t> pattern;
-		std::array<uint8_t, 0x1000> nametable; //alt. vector
+		std::array<uint8_t, 0x1000> nametable{}; //alt. vector
+
+		//chr as 2 bit pixels, leftmost in the high bits. one entry per chr byte: a tile's low plane
+		//offsets hold its rows, the high plane offsets the same rows flipped. built on load, chr ram
+		//and nametable rows are redecoded as they're written
+		std::vector<uint16_t> patternDecoded;
+		std::array<uint16_t, 0x1000> nametableDecoded{}; //n163 can fetch tiles from ciram
+		std::array<uint16_t*, 8> pDecoded{};
+		std::array<uint16_t*, 8> pSpriteDecoded{};
 
-		std::array<uint8_t, 32> paletteIndices;
-		uint32_t emphasisMask = 0xFFFFFFFF;
+		std::array<uint8_t, 32> paletteIndices{};
 		uint8_t grayscaleMask = 0xFF;
 
 		std::array<uint8_t, 64*4> oam;
-		std::array<uint8_t, 8*4> oam2;
+		std::array<uint8_t, 8*4> oam2{};
 
 		uint16_t renderPos = 0;
 
@@ -90,14 +171,14 @@ class Ppu
 		uint8_t oamAddr = 0;
 
 		uint16_t scanlineH = 340, scanlineV = 261;
-		uint16_t ppuAddress, ppuAddressLatch; //v,t rename?
+		uint16_t ppuAddress = 0, ppuAddressLatch = 0; //v,t rename?
 
-		uint16_t ppuAddressBus;
-		uint8_t nametableA; //rename
-		uint32_t attribute;
-		uint8_t attributeLatch;
-		uint16_t bgLow, bgHigh;
-		uint8_t bgLowLatch, bgHighLatch;
+		uint16_t ppuAddressBus = 0;
+		uint8_t nametableA = 0; //rename
+		uint32_t attribute = 0;
+		uint8_t attributeLatch = 0;
+		uint32_t bgPixels = 0; //2 bits per pixel like the chr cache
+		uint16_t bgLatch = 0;
 
 		bool wToggle = false;
 
@@ -108,20 +189,36 @@ class Ppu
 		uint8_t oamEvalPattern = 0;
 		uint8_t oamSpritenum = 0; //0-3 = sprite0, 4-7 = sprite1 [...] 252-255 = sprite63
 		uint8_t oamDiagonal = 0;
+		bool oamEvalBulk = false; //this line was evaluated at dot 66, the per dot machine above stays idle
+		uint16_t overflowDot = 0; //when the per dot machine would set sprite overflow, 0 = never
 
 		bool suppressNmi = false;
 		uint8_t nmiFlag = 0x80;
 
-		std::array<uint8_t, 8> spriteBitmapLow;
-		std::array<uint8_t, 8> spriteBitmapHigh;
-		std::array<uint8_t, 8> spriteAttribute;
-		std::array<uint8_t, 8> spriteXpos;
+		std::array<uint16_t, 8> spriteBitmap{};
+		std::array<uint8_t, 8> spriteAttribute{};
+		std::array<uint8_t, 8> spriteXpos{};
 		uint8_t spriteIndex = 0;
 
 		bool sprite0OnNext = false;
 		bool sprite0OnCurrent = false;
 
-		bool isChrRam;
+		bool isChrRam = false;
+
+		ChrLatch chrLatch;
+
+		const uint8_t *exAttribute = nullptr; //mmc5 exram in extended attribute mode
+		uint16_t exAttributeHigh = 0;
+		uint8_t exAttributeLatch = 0;
+
+		const uint8_t *split = nullptr; //mmc5 exram as the nametable of the split region
+		uint8_t splitControl = 0, splitScroll = 0, splitY = 0, splitAttribute = 0;
+		uint16_t splitBank = 0;
+		bool splitTile = false; //the tile being fetched comes from the split
 
 		uint8_t TToVDelay = 0;
+
+		PpuSnapshot *snapshot = nullptr;
+		uint16_t frameScroll = 0; //v after the prerender line's copy, for the snapshot
+		uint8_t frameFineX = 0;
 };
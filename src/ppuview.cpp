@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "ppuview.hpp"
+
+
+bool PpuViewer::Update(const PpuSnapshot &snapshot)
+{
+	if(snapshot.palette != last.palette || snapshot.colors != last.colors)
+	{
+		redrawAll = true;
+	}
+
+	bool changed = redrawAll;
+	for(uint16_t tile = 0; tile < 512; ++tile)
+	{
+		tileChanged[tile] = redrawAll || !std::equal(&snapshot.tiles[tile * 8], &snapshot.tiles[tile * 8 + 8], &last.tiles[tile * 8]);
+		changed |= tileChanged[tile];
+	}
+
+	//nametables, each cell is redrawn when its tile, its tile's pattern or its attribute changes
+	const uint16_t bgTable = (snapshot.ctrl & 0x10) << 4;
+	const bool bgTableChanged = (snapshot.ctrl ^ last.ctrl) & 0x10;
+	for(uint16_t quadrant = 0; quadrant < 0x1000; quadrant += 0x400)
+	{
+		for(uint16_t cell = 0; cell < 960; ++cell)
+		{
+			const uint16_t x = cell & 31, y = cell >> 5;
+			const uint16_t attribute = quadrant + 0x3C0 + (y >> 2) * 8 + (x >> 2);
+			const uint8_t shift = ((y & 2) << 1) | (x & 2);
+			const uint8_t palette = (snapshot.nametables[attribute] >> shift) & 0b11;
+			const uint16_t tile = bgTable | snapshot.nametables[quadrant + cell];
+			if(bgTableChanged || tileChanged[tile] || snapshot.nametables[quadrant + cell] != last.nametables[quadrant + cell] || palette != ((last.nametables[attribute] >> shift) & 0b11))
+			{
+				const uint32_t position = ((quadrant >> 11) * 240 + y * 8) * 512 + ((quadrant >> 10) & 1) * 256 + x * 8;
+				DrawTile(snapshot, &nametables[position], 512, tile, palette, 0);
+				changed = true;
+			}
+		}
+	}
+
+	for(uint16_t tile = 0; tile < 512; ++tile)
+	{
+		if(tileChanged[tile])
+		{
+			const uint32_t position = ((tile >> 4) & 15) * 8 * 256 + (tile >> 8) * 128 + (tile & 15) * 8;
+			DrawTile(snapshot, &patternTables[position], 256, tile, patternPalette, 0);
+		}
+	}
+
+	//sprites, 8x16 ones take their table from the tile number and swap halves when flipped vertically
+	const bool tall = snapshot.ctrl & 0b00100000;
+	const bool spriteModeChanged = (snapshot.ctrl ^ last.ctrl) & 0b00101000;
+	for(uint8_t sprite = 0; sprite < 64; ++sprite)
+	{
+		const uint8_t *entry = &snapshot.oam[sprite * 4];
+		uint16_t top = ((snapshot.ctrl & 0b1000) << 5) | entry[1];
+		if(tall)
+		{
+			top = ((entry[1] & 1) << 8) | (entry[1] & 0xFE);
+		}
+		const bool spriteChanged = !std::equal(entry, entry + 4, &last.oam[sprite * 4]);
+		if(redrawAll || spriteModeChanged || spriteChanged || tileChanged[top] || (tall && tileChanged[top + 1]))
+		{
+			uint32_t *cell = &sprites[(sprite >> 3) * 16 * 64 + (sprite & 7) * 8];
+			const uint8_t flip = entry[2] >> 6;
+			const uint8_t palette = 4 + (entry[2] & 0b11);
+			if(tall)
+			{
+				DrawTile(snapshot, cell, 64, top + (flip >> 1), palette, flip);
+				DrawTile(snapshot, cell + 8 * 64, 64, top + !(flip >> 1), palette, flip);
+			}
+			else
+			{
+				DrawTile(snapshot, cell, 64, top, palette, flip);
+				for(uint8_t row = 8; row < 16; ++row)
+				{
+					std::fill(cell + row * 64, cell + row * 64 + 8, 0);
+				}
+			}
+			changed = true;
+		}
+	}
+
+	last = snapshot;
+	redrawAll = false;
+	return changed;
+}
+
+
+void PpuViewer::SetPatternPalette(const uint8_t palette)
+{
+	if(palette != patternPalette)
+	{
+		patternPalette = palette & 7;
+		redrawAll = true;
+	}
+}
+
+
+const uint32_t* const PpuViewer::GetNametables() const
+{
+	return nametables.data();
+}
+
+
+const uint32_t* const PpuViewer::GetPatternTables() const
+{
+	return patternTables.data();
+}
+
+
+const uint32_t* const PpuViewer::GetSprites() const
+{
+	return sprites.data();
+}
+
+
+const std::array<uint16_t, 2> PpuViewer::ScrollPosition() const
+{
+	const uint16_t v = last.scroll;
+	const uint16_t x = ((v >> 10) & 1) * 256 + (v & 31) * 8 + last.fineX;
+	const uint16_t y = ((v >> 11) & 1) * 240 + ((v >> 5) & 31) * 8 + ((v >> 12) & 7);
+	return {{x, y}};
+}
+
+
+void PpuViewer::DrawTile(const PpuSnapshot &snapshot, uint32_t *image, const uint16_t width, const uint16_t tile, const uint8_t palette, const uint8_t flip)
+{
+	for(uint8_t row = 0; row < 8; ++row)
+	{
+		const uint16_t pixels = snapshot.tiles[tile * 8 + ((flip & 2) ? 7 - row : row)];
+		for(uint8_t x = 0; x < 8; ++x)
+		{
+			image[row * width + ((flip & 1) ? 7 - x : x)] = Color(snapshot, palette, (pixels >> (14 - x * 2)) & 0b11);
+		}
+	}
+}
+
+
+const uint32_t PpuViewer::Color(const PpuSnapshot &snapshot, const uint8_t palette, const uint8_t pixel) const
+{
+	return snapshot.colors[snapshot.palette[pixel ? palette * 4 + pixel : 0] & 0x3F];
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "ppu.hpp"
+
+
+//rgba images of the nametables, pattern tables and sprites for the debug windows. each update
+//compares the snapshot with the previous one and only redraws the tiles that changed
+class PpuViewer
+{
+	public:
+		bool Update(const PpuSnapshot &snapshot); //false if nothing changed
+		void SetPatternPalette(const uint8_t palette); //0-3 background, 4-7 sprites
+
+		const uint32_t* const GetNametables() const;   //512x480, the 4 quadrants
+		const uint32_t* const GetPatternTables() const; //256x128, $0000 left and $1000 right
+		const uint32_t* const GetSprites() const;       //64x128, oam order in 8 rows of 8x16 cells
+		const std::array<uint16_t, 2> ScrollPosition() const; //top left of the visible area in the nametables
+
+	private:
+		void DrawTile(const PpuSnapshot &snapshot, uint32_t *image, const uint16_t width, const uint16_t tile, const uint8_t palette, const uint8_t flip);
+		const uint32_t Color(const PpuSnapshot &snapshot, const uint8_t palette, const uint8_t pixel) const;
+
+		std::array<uint32_t, 512*480> nametables{};
+		std::array<uint32_t, 256*128> patternTables{};
+		std::array<uint32_t, 64*128> sprites{};
+
+		PpuSnapshot last;
+		std::array<bool, 512> tileChanged{};
+		uint8_t patternPalette = 0;
+		bool redrawAll = true;
+};
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "profiler.hpp"
+
+
+Profiler::Profiler()
+{
+	Resize(0);
+}
+
+
+void Profiler::Resize(const size_t prgSize)
+{
+	if(cycles.size() != 0x8000 + prgSize)
+	{
+		cycles.assign(0x8000 + prgSize, 0);
+		addresses.assign(0x8000 + prgSize, 0);
+		Clear();
+	}
+}
+
+
+void Profiler::Clear()
+{
+	std::fill(cycles.begin(), cycles.end(), 0);
+	nodes.clear();
+	nodes.push_back(Node());
+	nodes[0].parent = 0;
+	nodes[0].location = 0;
+	nodes[0].kind = ProfileRoot;
+	calls.clear();
+	current = 0;
+	frames = 0;
+	pending = ProfileNone;
+}
+
+
+void Profiler::Start(const uint32_t cycle)
+{
+	lastCycle = cycle;
+	pending = ProfileNone;
+}
+
+
+void Profiler::Interrupt(const uint32_t location, const uint16_t address, const uint32_t cycle, const uint8_t stack, const ProfileKind kind)
+{
+	Flush(cycle); //the 7 cycles of the interrupt itself stay with what it interrupted
+	lastLocation = location;
+	lastAddress = address;
+	if(pending != ProfileNone)
+	{
+		ApplyPending(stack);
+	}
+	Enter(location, kind, stack);
+}
+
+
+void Profiler::EndFrame()
+{
+	++frames;
+}
+
+
+void Profiler::ApplyPending(const uint8_t stack)
+{
+	if(pending == ProfileCall)
+	{
+		Enter(pendingTarget, ProfileSubroutine, pendingStack);
+	}
+	else
+	{
+		//everything called at or below where s is now has returned, which also covers rts used as a jump
+		//and code that resets the stack instead of returning
+		while(!calls.empty() && calls.back().stack <= stack)
+		{
+			current = nodes[calls.back().node].parent;
+			calls.pop_back();
+		}
+	}
+	pending = ProfileNone;
+}
+
+
+void Profiler::Enter(const uint32_t location, const ProfileKind kind, const uint8_t stack)
+{
+	if(calls.size() == 256) //deeper than the stack can be, something isn't returning the usual way
+	{
+		return;
+	}
+
+	uint32_t child = 0;
+	for(const uint32_t x : nodes[current].children)
+	{
+		if(nodes[x].location == location && nodes[x].kind == kind)
+		{
+			child = x;
+			break;
+		}
+	}
+	if(!child)
+	{
+		child = nodes.size();
+		nodes.push_back(Node());
+		nodes[child].parent = current;
+		nodes[child].location = location;
+		nodes[child].kind = kind;
+		nodes[current].children.push_back(child);
+	}
+
+	++nodes[child].calls;
+	calls.push_back({child, stack});
+	current = child;
+}
+
+
+const std::vector<uint64_t> Profiler::Totals() const
+{
+	//children are always added after their parent
+	std::vector<uint64_t> totals(nodes.size(), 0);
+	for(size_t x = nodes.size(); x-- > 0;)
+	{
+		totals[x] += nodes[x].self;
+		if(x)
+		{
+			totals[nodes[x].parent] += totals[x];
+		}
+	}
+	return totals;
+}
+
+
+void Profiler::Report(std::ostream &out) const
+{
+	const std::vector<uint64_t> totals = Totals();
+	const double all = std::max<uint64_t>(totals[0], 1);
+	const double perFrame = std::max<uint32_t>(frames, 1);
+	char line[128];
+
+	std::snprintf(line, sizeof(line), "%u frames, %llu cycles\n", frames, (unsigned long long)totals[0]);
+	out << line;
+
+	std::vector<uint32_t> locations;
+	for(uint32_t x = 0; x < cycles.size(); ++x)
+	{
+		if(cycles[x])
+		{
+			locations.push_back(x);
+		}
+	}
+	std::sort(locations.begin(), locations.end(), [this](const uint32_t a, const uint32_t b) { return cycles[a] > cycles[b]; });
+	out << "\nflat, by instruction\n      cycles      %     /frame  location\n";
+	for(size_t x = 0; x < locations.size() && x < 100; ++x)
+	{
+		const uint64_t count = cycles[locations[x]];
+		std::snprintf(line, sizeof(line), "%12llu %6.2f %10.1f  %s\n", (unsigned long long)count, count * 100 / all, count / perFrame, Name(locations[x], ProfileSubroutine).c_str());
+		out << line;
+	}
+
+	//the same subroutine called from different places is one line here, recursion counts it more than once
+	std::map<std::pair<uint32_t, ProfileKind>, std::array<uint64_t, 3>> subroutines; //calls, self, total
+	for(uint32_t x = 1; x < nodes.size(); ++x)
+	{
+		std::array<uint64_t, 3> &entry = subroutines[{nodes[x].location, nodes[x].kind}];
+		entry[0] += nodes[x].calls;
+		entry[1] += nodes[x].self;
+		entry[2] += totals[x];
+	}
+	std::vector<std::pair<std::pair<uint32_t, ProfileKind>, std::array<uint64_t, 3>>> sorted(subroutines.begin(), subroutines.end());
+	std::sort(sorted.begin(), sorted.end(), [](const decltype(sorted)::value_type &a, const decltype(sorted)::value_type &b) { return a.second[2] > b.second[2]; });
+	out << "\nsubroutines\n  total %  self %      calls   cycles/frame  entry\n";
+	for(const auto &entry : sorted)
+	{
+		std::snprintf(line, sizeof(line), "%9.2f %7.2f %10llu %14.1f  %s\n", entry.second[2] * 100 / all, entry.second[1] * 100 / all,
+			(unsigned long long)entry.second[0], entry.second[2] / perFrame, Name(entry.first.first, entry.first.second).c_str());
+		out << line;
+	}
+
+	out << "\ncall tree, total % / self % / calls\n";
+	PrintTree(out, totals, 0, 0);
+}
+
+
+bool Profiler::SaveReport(const std::string &path) const
+{
+	std::ofstream output(path.c_str(), std::ios::out | std::ios::trunc);
+	if(!output.is_open())
+	{
+		std::cout << "Could not create " << path << std::endl;
+		return false;
+	}
+
+	Report(output);
+	return output.good();
+}
+
+
+void Profiler::PrintTree(std::ostream &out, const std::vector<uint64_t> &totals, const uint32_t node, const uint16_t depth) const
+{
+	const double all = std::max<uint64_t>(totals[0], 1);
+	char line[128];
+	std::snprintf(line, sizeof(line), "%*s%6.2f %6.2f %8u  %s\n", depth * 2, "", totals[node] * 100 / all, nodes[node].self * 100 / all, nodes[node].calls, Name(nodes[node].location, nodes[node].kind).c_str());
+	out << line;
+
+	std::vector<uint32_t> children = nodes[node].children;
+	std::sort(children.begin(), children.end(), [&totals](const uint32_t a, const uint32_t b) { return totals[a] > totals[b]; });
+	for(const uint32_t child : children)
+	{
+		if(totals[child] * 1000 >= totals[0]) //below 0.1% is left out
+		{
+			PrintTree(out, totals, child, depth + 1);
+		}
+	}
+}
+
+
+const std::string Profiler::Name(const uint32_t location, const ProfileKind kind) const
+{
+	if(kind == ProfileRoot)
+	{
+		return "frame";
+	}
+
+	const char *prefix = (kind == ProfileNmi) ? "nmi " : (kind == ProfileIrq) ? "irq " : "";
+	char text[32];
+	if(location < 0x8000)
+	{
+		std::snprintf(text, sizeof(text), "%s$%04X", prefix, location);
+	}
+	else
+	{
+		std::snprintf(text, sizeof(text), "%s%02X:%04X", prefix, (location - 0x8000) >> 13, addresses[location]);
+	}
+	return text;
+}
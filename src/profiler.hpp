@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+enum ProfileOp : uint8_t {ProfileNone, ProfileCall, ProfileReturn};
+enum ProfileKind : uint8_t {ProfileRoot, ProfileSubroutine, ProfileNmi, ProfileIrq};
+
+//where the emulated cpu spends its cycles, counted with the cpu's own cycle counter so runs are repeatable.
+//locations are cpu addresses below $8000 and $8000 + the prg rom offset above, so banks are told apart
+class Profiler
+{
+	public:
+		Profiler();
+		void Resize(const size_t prgSize); //keeps the profile if the rom is the same size
+		void Clear();
+		void Start(const uint32_t cycle); //counting starts here, not at the last instruction seen before
+
+		//before each instruction, the elapsed cycles go to the previous one. jsr, rts and rti act on the call tree
+		//once they have run, so their own cycles stay with the caller or callee they belong to
+		void Instruction(const uint32_t location, const uint16_t address, const uint32_t cycle, const uint8_t stack, const ProfileOp op, const uint32_t target)
+		{
+			Flush(cycle);
+			lastLocation = location;
+			lastAddress = address;
+
+			if(pending != ProfileNone)
+			{
+				ApplyPending(stack);
+			}
+			pending = op;
+			pendingTarget = target;
+			pendingStack = stack;
+		}
+		void Interrupt(const uint32_t location, const uint16_t address, const uint32_t cycle, const uint8_t stack, const ProfileKind kind); //when the handler is entered
+		void EndFrame();
+
+		void Report(std::ostream &out) const; //flat profile, subroutines and the call tree
+		bool SaveReport(const std::string &path) const;
+
+	private:
+		struct Node
+		{
+			uint32_t parent, location;
+			ProfileKind kind;
+			uint64_t self = 0;
+			uint32_t calls = 0;
+			std::vector<uint32_t> children;
+		};
+		struct Call
+		{
+			uint32_t node;
+			uint8_t stack; //s before the call pushed anything, returning to it ends the call
+		};
+
+		void Flush(const uint32_t cycle)
+		{
+			const uint32_t elapsed = cycle - lastCycle;
+			lastCycle = cycle;
+			cycles[lastLocation] += elapsed;
+			nodes[current].self += elapsed;
+			addresses[lastLocation] = lastAddress;
+		}
+		void ApplyPending(const uint8_t stack);
+		void Enter(const uint32_t location, const ProfileKind kind, const uint8_t stack);
+		const std::vector<uint64_t> Totals() const; //self and everything called from there, per node
+		void PrintTree(std::ostream &out, const std::vector<uint64_t> &totals, const uint32_t node, const uint16_t depth) const;
+		const std::string Name(const uint32_t location, const ProfileKind kind) const;
+
+		std::vector<uint64_t> cycles;
+		std::vector<uint16_t> addresses; //where each location was last run, for the report
+		std::vector<Node> nodes;
+		std::vector<Call> calls;
+		uint32_t current = 0;
+		uint32_t frames = 0;
+
+		uint32_t lastCycle = 0, lastLocation = 0;
+		uint16_t lastAddress = 0;
+		ProfileOp pending = ProfileNone;
+		uint32_t pendingTarget = 0;
+		uint8_t pendingStack = 0;
+};
@@ -0,0 +1,260 @@
+#include <cstring>
+
+#include "rewind.hpp"
+
+
+//zero runs and literal runs, each length as a varint. xored states are mostly zeros,
+//the rest changes in small scattered groups, so this is most of what lz4 would get
+static void PutLength(std::vector<uint8_t> &out, size_t length)
+{
+	while(length >= 0x80)
+	{
+		out.push_back(length | 0x80);
+		length >>= 7;
+	}
+	out.push_back(length);
+}
+
+
+static const size_t GetLength(const std::vector<uint8_t> &in, size_t &position)
+{
+	size_t length = 0;
+	for(uint8_t shift = 0; position < in.size(); shift += 7)
+	{
+		const uint8_t byte = in[position++];
+		length |= size_t(byte & 0x7F) << shift;
+		if(!(byte & 0x80))
+		{
+			break;
+		}
+	}
+	return length;
+}
+
+
+static void Pack(const uint8_t *data, const size_t size, std::vector<uint8_t> &out)
+{
+	out.clear();
+	size_t x = 0;
+	while(x < size)
+	{
+		const size_t zeroStart = x;
+		uint64_t word;
+		while(x + 8 <= size && (std::memcpy(&word, data + x, 8), !word)) //most of a delta
+		{
+			x += 8;
+		}
+		while(x < size && !data[x])
+		{
+			++x;
+		}
+		const size_t literalStart = x;
+		while(x < size && !(x + 4 <= size && !(data[x] | data[x + 1] | data[x + 2] | data[x + 3]))) //short zero runs are cheaper as literals
+		{
+			++x;
+		}
+		PutLength(out, literalStart - zeroStart);
+		PutLength(out, x - literalStart);
+		out.insert(out.end(), data + literalStart, data + x);
+	}
+}
+
+
+Rewind::Rewind(const size_t budget, const uint16_t keyframeInterval) : budget(budget), keyframeInterval(keyframeInterval ? keyframeInterval : 1)
+{
+	worker = std::thread(&Rewind::Worker, this);
+}
+
+
+Rewind::~Rewind()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+
+void Rewind::Push(Nes &nes)
+{
+	std::vector<uint8_t> state;
+	{
+		//a worker that can't keep up slows the emulator down instead of eating memory
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [this]{ return pending.size() < 8; });
+		if(!spare.empty())
+		{
+			state = std::move(spare.back());
+			spare.pop_back();
+		}
+	}
+
+	nes.SaveState(state);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(std::move(state));
+	}
+	wake.notify_one();
+}
+
+
+bool Rewind::Pop(Nes &nes)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]{ return pending.empty() && !busy; });
+	if(snapshots.empty())
+	{
+		return false;
+	}
+
+	Unpack(snapshots.back(), delta);
+	nes.LoadState(delta);
+
+	const bool wasKeyframe = snapshots.back().keyframe;
+	memoryUsed -= snapshots.back().data.size();
+	snapshots.pop_back();
+
+	if(!wasKeyframe)
+	{
+		--sinceKeyframe;
+	}
+	else if(snapshots.empty())
+	{
+		keyframe.clear();
+		sinceKeyframe = 0;
+	}
+	else //back into the previous group, its keyframe becomes the reference again
+	{
+		size_t x = snapshots.size() - 1;
+		while(!snapshots[x].keyframe)
+		{
+			--x;
+		}
+		Unpack(snapshots[x], keyframe);
+		sinceKeyframe = snapshots.size() - x;
+	}
+	return true;
+}
+
+
+void Rewind::Clear()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]{ return pending.empty() && !busy; });
+	snapshots.clear();
+	keyframe.clear();
+	sinceKeyframe = 0;
+	memoryUsed = 0;
+}
+
+
+const size_t Rewind::Frames()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return snapshots.size() + pending.size();
+}
+
+
+const size_t Rewind::MemoryUsed()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memoryUsed;
+}
+
+
+void Rewind::Worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true)
+	{
+		wake.wait(lock, [this]{ return stop || !pending.empty(); });
+		if(pending.empty())
+		{
+			return;
+		}
+
+		std::vector<uint8_t> state = std::move(pending.front());
+		pending.pop_front();
+		busy = true;
+
+		lock.unlock();
+		Store(state);
+		lock.lock();
+
+		spare.push_back(std::move(state));
+		busy = false;
+		idle.notify_all();
+	}
+}
+
+
+void Rewind::Store(const std::vector<uint8_t> &state)
+{
+	Snapshot snapshot;
+	snapshot.keyframe = keyframe.empty() || sinceKeyframe == keyframeInterval;
+	if(snapshot.keyframe)
+	{
+		keyframe = state;
+		sinceKeyframe = 1;
+		Pack(state.data(), state.size(), packed);
+	}
+	else
+	{
+		delta.resize(state.size());
+		for(size_t x = 0; x < state.size(); ++x)
+		{
+			delta[x] = state[x] ^ keyframe[x];
+		}
+		++sinceKeyframe;
+		Pack(delta.data(), delta.size(), packed);
+	}
+	snapshot.data.assign(packed.begin(), packed.end());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	memoryUsed += snapshot.data.size();
+	snapshots.push_back(std::move(snapshot));
+
+	//drop whole groups from the old end, the newest one stays whatever its size
+	while(memoryUsed > budget)
+	{
+		size_t next = 1;
+		while(next < snapshots.size() && !snapshots[next].keyframe)
+		{
+			++next;
+		}
+		if(next == snapshots.size())
+		{
+			break;
+		}
+		for(size_t x = 0; x < next; ++x)
+		{
+			memoryUsed -= snapshots.front().data.size();
+			snapshots.pop_front();
+		}
+	}
+}
+
+
+void Rewind::Unpack(const Snapshot &snapshot, std::vector<uint8_t> &state)
+{
+	state.clear();
+	size_t position = 0;
+	while(position < snapshot.data.size())
+	{
+		state.resize(state.size() + GetLength(snapshot.data, position));
+		const size_t literals = GetLength(snapshot.data, position);
+		state.insert(state.end(), snapshot.data.begin() + position, snapshot.data.begin() + position + literals);
+		position += literals;
+	}
+
+	if(!snapshot.keyframe)
+	{
+		for(size_t x = 0; x < state.size(); ++x)
+		{
+			state[x] ^= keyframe[x];
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "nes.hpp"
+
+
+//frame history for stepping backwards. every frame's save state is queued as is, a worker thread
+//xors it against the last keyframe and run length packs the result, so the emulation thread
+//only pays for SaveState. the oldest keyframe groups are dropped to stay under the budget
+class Rewind
+{
+	public:
+		Rewind(const size_t budget = 64 << 20, const uint16_t keyframeInterval = 120);
+		Rewind(const Rewind&) = delete;
+		Rewind& operator=(const Rewind&) = delete;
+		~Rewind();
+
+		void Push(Nes &nes); //after every frame
+		bool Pop(Nes &nes);  //loads the newest snapshot and forgets it, false if there is none
+		void Clear();
+
+		const size_t Frames();
+		const size_t MemoryUsed();
+
+	private:
+		struct Snapshot
+		{
+			std::vector<uint8_t> data;
+			bool keyframe;
+		};
+
+		void Worker();
+		void Store(const std::vector<uint8_t> &state);
+		void Unpack(const Snapshot &snapshot, std::vector<uint8_t> &state);
+
+		const size_t budget;
+		const uint16_t keyframeInterval;
+
+		//owned by the worker while busy, by Pop once everything queued is stored
+		std::deque<Snapshot> snapshots;
+		std::vector<uint8_t> keyframe; //unpacked, the newest group is xored against it
+		std::vector<uint8_t> delta, packed;
+		uint16_t sinceKeyframe = 0;
+		size_t memoryUsed = 0;
+
+		std::deque<std::vector<uint8_t>> pending;
+		std::vector<std::vector<uint8_t>> spare; //recycled state buffers
+
+		std::thread worker;
+		std::mutex mutex;
+		std::condition_variable wake, idle;
+		bool busy = false;
+		bool stop = false;
+};
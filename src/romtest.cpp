@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "romtest.hpp"
+#include "threadpool.hpp"
+
+
+//runs every rom in a directory headless, for checking accuracy work against the performance work.
+//roms writing blargg's status protocol to $6000 report themselves, the others need a line in
+//the directory's expected.txt: rom.nes frame hash, as printed by -g
+int main(int argc, char* argv[])
+{
+	if(argc < 2 || argc % 2 != 0)
+	{
+		std::cout << "romtest directory [-f frames] [-j threads] [-g frame]" << std::endl;
+		std::cout << "  -f frames before a rom without a result times out, default 3600" << std::endl;
+		std::cout << "  -j worker threads, default all cores" << std::endl;
+		std::cout << "  -g print the frame hash of every rom at that frame, for expected.txt" << std::endl;
+		exit(0);
+	}
+
+	unsigned threads = std::thread::hardware_concurrency();
+	uint32_t timeout = 3600;
+	uint32_t generateFrame = 0;
+	for(int x = 2; x < argc; x += 2)
+	{
+		const std::string option = argv[x];
+		const uint32_t value = std::stoul(argv[x + 1]);
+		if(option == "-f")
+		{
+			timeout = value;
+		}
+		else if(option == "-j")
+		{
+			threads = value;
+		}
+		else if(option == "-g")
+		{
+			generateFrame = value;
+		}
+		else
+		{
+			std::cout << "unknown option " << option << std::endl;
+			exit(1);
+		}
+	}
+
+	const std::vector<RomTest> tests = ListRomTests(argv[1], generateFrame);
+	std::vector<RomTestResult> results(tests.size());
+
+	ThreadPool pool(threads);
+	const auto t1 = std::chrono::steady_clock::now();
+	for(size_t x = 0; x < tests.size(); ++x)
+	{
+		pool.Submit([&tests, &results, timeout, x]{ results[x] = RunRomTest(tests[x], timeout); });
+	}
+	pool.Wait();
+	const auto t2 = std::chrono::steady_clock::now();
+
+	const std::array<const char*, 5> statusName{{"PASS", "FAIL", "TIMEOUT", "UNKNOWN", "HASH"}};
+	std::array<uint32_t, 5> count{};
+	uint64_t totalFrames = 0;
+	for(size_t x = 0; x < tests.size(); ++x)
+	{
+		const RomTestResult &result = results[x];
+		++count[result.status];
+		totalFrames += result.frames;
+
+		if(result.status == TestHashed)
+		{
+			std::cout << tests[x].rom.substr(tests[x].rom.find_last_of('/') + 1) << " " << result.frames << " ";
+			std::cout << std::hex << std::setw(8) << std::setfill('0') << result.frameHash << std::dec << std::endl;
+			continue;
+		}
+
+		std::cout << std::left << std::setw(8) << std::setfill(' ') << statusName[result.status] << std::right << tests[x].rom;
+		if(!result.loaded)
+		{
+			std::cout << ", could not be loaded" << std::endl;
+			continue;
+		}
+		std::cout << ", " << result.frames << " frames, " << uint64_t(result.frames / result.seconds) << " fps";
+		if(result.status == TestFail)
+		{
+			if(result.jammed)
+			{
+				std::cout << ", cpu jammed";
+			}
+			else if(tests[x].hashFrame)
+			{
+				std::cout << ", frame hash " << std::hex << std::setw(8) << std::setfill('0') << result.frameHash << std::dec;
+			}
+			else
+			{
+				std::cout << ", result " << uint32_t(result.code);
+			}
+		}
+		std::cout << std::endl;
+
+		std::istringstream message(result.message);
+		std::string line;
+		while(std::getline(message, line))
+		{
+			if(!line.empty() && result.status != TestPass)
+			{
+				std::cout << "        " << line << std::endl;
+			}
+		}
+	}
+
+	if(generateFrame) //straight into expected.txt
+	{
+		return 0;
+	}
+
+	const double seconds = std::chrono::duration<double>(t2 - t1).count();
+	std::cout << tests.size() << " roms, " << count[TestPass] << " passed, " << count[TestFail] << " failed, ";
+	std::cout << count[TestTimeout] << " timed out, " << count[TestUnknown] << " unknown, ";
+	std::cout << totalFrames << " frames in " << seconds << "s on " << pool.Size() << " threads" << std::endl;
+
+	return (count[TestFail] || count[TestTimeout] || count[TestUnknown]) ? 1 : 0;
+}
+
+
+const std::vector<RomTest> ListRomTests(const std::string &directory, const uint32_t generateFrame)
+{
+	DIR *dir = opendir(directory.c_str());
+	if(!dir)
+	{
+		std::cout << "Could not open " << directory << std::endl;
+		exit(1);
+	}
+
+	std::vector<std::string> roms;
+	while(const dirent *entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if(name.size() > 4)
+		{
+			std::string extension = name.substr(name.size() - 4);
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if(extension == ".nes")
+			{
+				roms.push_back(name);
+			}
+		}
+	}
+	closedir(dir);
+	std::sort(roms.begin(), roms.end());
+
+	std::vector<RomTest> tests;
+	for(const auto &name : roms)
+	{
+		RomTest test;
+		test.rom = directory + "/" + name;
+		if(generateFrame)
+		{
+			test.hashFrame = generateFrame;
+			test.generate = true;
+		}
+		tests.push_back(test);
+	}
+
+	std::ifstream expected((directory + "/expected.txt").c_str());
+	std::string line;
+	uint32_t lineNumber = 0;
+	while(!generateFrame && std::getline(expected, line))
+	{
+		++lineNumber;
+		std::istringstream fields(line);
+		std::string name, hash;
+		uint32_t frame = 0;
+		if(!(fields >> name) || name[0] == '#')
+		{
+			continue;
+		}
+		if(!(fields >> frame >> hash) || !frame)
+		{
+			std::cout << directory << "/expected.txt:" << lineNumber << " should be: rom.nes frame hash" << std::endl;
+			exit(1);
+		}
+
+		auto test = std::find_if(tests.begin(), tests.end(), [&](const RomTest &t){ return t.rom == directory + "/" + name; });
+		if(test == tests.end())
+		{
+			std::cout << directory << "/expected.txt:" << lineNumber << " " << name << " not found" << std::endl;
+			exit(1);
+		}
+		test->hashFrame = frame;
+		test->expectedHash = std::stoul(hash, nullptr, 16);
+	}
+
+	return tests;
+}
+
+
+const RomTestResult RunRomTest(const RomTest &test, const uint32_t timeout)
+{
+	RomTestResult result;
+	const auto t1 = std::chrono::steady_clock::now();
+
+	std::unique_ptr<Nes> nes(new Nes(test.rom, BatteryOff));
+	if(!nes->Loaded())
+	{
+		result.status = TestFail;
+		return result;
+	}
+	result.loaded = true;
+	nes->ppu.SetPixelFormat(Indexed); //hashes stay valid when the palette changes
+
+	//$6000 status, $6001-$6003 de b0 61 once it's valid, $6004 on a zero terminated message
+	auto protocolValid = [&nes]
+	{
+		return nes->DebugRead(0x6001) == 0xDE && nes->DebugRead(0x6002) == 0xB0 && nes->DebugRead(0x6003) == 0x61;
+	};
+
+	uint32_t resetFrame = 0;
+	bool resetDone = false;
+	const uint32_t frames = test.hashFrame ? test.hashFrame : timeout;
+	while(result.frames < frames)
+	{
+		//only the hashed frame is drawn
+		const bool hashed = test.hashFrame && result.frames + 1 == test.hashFrame;
+		nes->AdvanceFrame(0, 0, hashed ? SkipAudio : SkipVideo | SkipAudio);
+		++result.frames;
+		if(nes->Jammed())
+		{
+			break;
+		}
+
+		if(test.hashFrame || !protocolValid())
+		{
+			continue;
+		}
+
+		const uint8_t status = nes->DebugRead(0x6000);
+		if(status == 0x81) //wants a reset after at least 100 ms
+		{
+			if(!resetDone && !resetFrame)
+			{
+				resetFrame = result.frames + 6;
+			}
+			else if(resetFrame == result.frames)
+			{
+				nes->Reset();
+				resetFrame = 0;
+				resetDone = true;
+			}
+		}
+		else
+		{
+			resetDone = false;
+		}
+
+		if(status < 0x80)
+		{
+			result.code = status;
+			result.status = status ? TestFail : TestPass;
+			break;
+		}
+	}
+
+	if(nes->Jammed())
+	{
+		result.status = TestFail;
+		result.jammed = true;
+	}
+	else if(test.hashFrame)
+	{
+		result.frameHash = FrameHash(nes->ppu);
+		result.status = test.generate ? TestHashed : (result.frameHash == test.expectedHash ? TestPass : TestFail);
+	}
+	else if(result.status == TestUnknown && protocolValid())
+	{
+		result.status = TestTimeout;
+	}
+
+	if(protocolValid())
+	{
+		for(uint16_t address = 0x6004; address < 0x7000 && nes->DebugRead(address); ++address)
+		{
+			result.message += char(nes->DebugRead(address));
+		}
+	}
+
+	const auto t2 = std::chrono::steady_clock::now();
+	result.seconds = std::chrono::duration<double>(t2 - t1).count();
+	return result;
+}
+
+
+const uint32_t FrameHash(const Ppu &ppu)
+{
+	std::vector<uint8_t> frame(ppu.GetIndexPtr(), ppu.GetIndexPtr() + 256 * 240);
+	frame.insert(frame.end(), ppu.GetEmphasisPtr(), ppu.GetEmphasisPtr() + 240);
+	return StateHash(frame.data(), frame.size());
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nes.hpp"
+
+
+enum TestStatus : uint8_t {TestPass, TestFail, TestTimeout, TestUnknown, TestHashed};
+
+//a rom either reports through the $6000 protocol or is checked by its frame hash at a fixed frame
+struct RomTest
+{
+	std::string rom;
+	uint32_t hashFrame = 0; //0 = status protocol
+	uint32_t expectedHash = 0;
+	bool generate = false;  //only print the hash, there's nothing to compare against yet
+};
+
+struct RomTestResult
+{
+	TestStatus status = TestUnknown;
+	bool loaded = false;    //the rom could be read and its board is supported
+	uint8_t code = 0;       //the rom's result byte, 1 and up are its own failure numbers
+	std::string message;
+	uint32_t frames = 0;
+	uint32_t frameHash = 0;
+	bool jammed = false;    //stopped early on a KIL opcode
+	double seconds = 0;
+};
+
+
+const std::vector<RomTest> ListRomTests(const std::string &directory, const uint32_t generateFrame);
+const RomTestResult RunRomTest(const RomTest &test, const uint32_t timeout);
+const uint32_t FrameHash(const Ppu &ppu);
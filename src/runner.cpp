@@ -0,0 +1,207 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "runner.hpp"
+#include "threadpool.hpp"
+#include "nes.hpp"
+#include "movie.hpp"
+
+
+//headless batch runner for rom sweeps and fuzzing, nothing in the core is shared between instances
+int main(int argc, char* argv[])
+{
+	if(argc < 2 || argc % 2 != 0)
+	{
+		std::cout << "nesrun jobs.txt [-j threads] [-f frames] [-s seed]" << std::endl;
+		std::cout << "  one job per line: rom.nes [frames] [movie]" << std::endl;
+		std::cout << "  -j worker threads, default all cores" << std::endl;
+		std::cout << "  -f frames for jobs without a frame count or movie, default 600" << std::endl;
+		std::cout << "  -s random controller input for jobs without a movie, each job gets seed + line" << std::endl;
+		exit(0);
+	}
+
+	unsigned threads = std::thread::hardware_concurrency();
+	uint32_t frames = 600;
+	uint32_t seed = 0;
+	for(int x = 2; x < argc; x += 2)
+	{
+		const std::string option = argv[x];
+		const uint32_t value = std::stoul(argv[x + 1]);
+		if(option == "-j")
+		{
+			threads = value;
+		}
+		else if(option == "-f")
+		{
+			frames = value;
+		}
+		else if(option == "-s")
+		{
+			seed = value;
+		}
+		else
+		{
+			std::cout << "unknown option " << option << std::endl;
+			exit(1);
+		}
+	}
+
+	const std::vector<Job> jobs = ReadJobs(argv[1], frames, seed);
+	std::vector<JobResult> results(jobs.size());
+
+	ThreadPool pool(threads);
+	const auto t1 = std::chrono::steady_clock::now();
+	for(size_t x = 0; x < jobs.size(); ++x)
+	{
+		pool.Submit([&jobs, &results, x]{ results[x] = RunJob(jobs[x]); });
+	}
+	pool.Wait();
+	const auto t2 = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(t2 - t1).count();
+
+	uint64_t totalFrames = 0;
+	double busySeconds = 0;
+	int failed = 0;
+	for(size_t x = 0; x < jobs.size(); ++x)
+	{
+		const JobResult &result = results[x];
+		totalFrames += result.frames;
+		busySeconds += result.seconds;
+
+		std::cout << jobs[x].rom << ": ";
+		if(!result.loaded)
+		{
+			std::cout << "could not be loaded" << std::endl;
+			++failed;
+			continue;
+		}
+		if(!result.started)
+		{
+			std::cout << "movie " << jobs[x].movie << " could not be played" << std::endl;
+			++failed;
+			continue;
+		}
+		std::cout << result.frames << " frames, state " << std::hex << std::setw(8) << std::setfill('0') << result.stateHash << std::dec;
+		if(result.desyncFrame != -1)
+		{
+			std::cout << ", desync at frame " << result.desyncFrame;
+			++failed;
+		}
+		if(result.jammed)
+		{
+			std::cout << ", cpu jammed";
+			++failed;
+		}
+		std::cout << std::endl;
+	}
+
+	std::cout << jobs.size() << " jobs, " << totalFrames << " frames in " << seconds << "s on " << pool.Size() << " threads: ";
+	std::cout << uint64_t(totalFrames / seconds) << " fps, " << uint64_t(totalFrames / seconds / pool.Size()) << " fps per core";
+	std::cout << " (" << uint64_t(totalFrames / busySeconds) << " per busy core)" << std::endl;
+
+	return failed ? 1 : 0;
+}
+
+
+const std::vector<Job> ReadJobs(const std::string &jobFile, const uint32_t frames, const uint32_t seed)
+{
+	std::ifstream input(jobFile.c_str());
+	if(!input.is_open())
+	{
+		std::cout << "Could not open " << jobFile << std::endl;
+		exit(1);
+	}
+
+	std::vector<Job> jobs;
+	std::string line;
+	uint32_t lineNumber = 0;
+	while(std::getline(input, line))
+	{
+		++lineNumber;
+		std::istringstream fields(line);
+		Job job;
+		if(!(fields >> job.rom) || job.rom[0] == '#')
+		{
+			continue;
+		}
+
+		std::string field;
+		if(fields >> field)
+		{
+			//a number is a frame count unless there's a movie by that name
+			if(field.find_first_not_of("0123456789") == std::string::npos && !std::ifstream(field.c_str()).is_open())
+			{
+				job.frames = std::stoul(field);
+				field.clear();
+				fields >> field;
+			}
+			job.movie = field;
+		}
+		if(job.movie.empty() && !job.frames)
+		{
+			job.frames = frames;
+		}
+		if(job.movie.empty() && !job.frames)
+		{
+			std::cout << jobFile << ":" << lineNumber << " needs a frame count or a movie" << std::endl;
+			exit(1);
+		}
+		if(job.movie.empty() && seed)
+		{
+			job.seed = seed + lineNumber;
+		}
+		jobs.push_back(job);
+	}
+	return jobs;
+}
+
+
+const JobResult RunJob(const Job &job)
+{
+	JobResult result;
+	const auto t1 = std::chrono::steady_clock::now();
+
+	//large, and only a few are alive at once
+	std::unique_ptr<Nes> nes(new Nes(job.rom, job.movie.empty() ? BatteryOff : BatteryCopy)); //movies start from the .sav they were recorded with
+	if(!nes->Loaded())
+	{
+		return result;
+	}
+	result.loaded = true;
+	Movie movie;
+	if(!job.movie.empty() && !movie.Play(job.movie, *nes))
+	{
+		return result;
+	}
+	result.started = true;
+
+	uint32_t random = job.seed;
+	while((!job.frames || result.frames < job.frames) && (job.movie.empty() || movie.GetMode() == MoviePlay) && !nes->Jammed())
+	{
+		InputFrame frame;
+		if(random)
+		{
+			random ^= random << 13; //xorshift32
+			random ^= random >> 17;
+			random ^= random << 5;
+			frame.pads[0] = random;
+			frame.pads[1] = random >> 8;
+		}
+		movie.AdvanceFrame(*nes, frame, SkipVideo | SkipAudio);
+		++result.frames;
+	}
+
+	std::vector<uint8_t> state;
+	nes->SaveState(state);
+	result.stateHash = StateHash(state.data(), state.size());
+	result.desyncFrame = movie.GetDesyncFrame();
+	result.jammed = nes->Jammed();
+
+	const auto t2 = std::chrono::steady_clock::now();
+	result.seconds = std::chrono::duration<double>(t2 - t1).count();
+	return result;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+//one independent emulator, its own rom, movie and length
+struct Job
+{
+	std::string rom;
+	uint32_t frames = 0;  //0 = until the movie ends
+	std::string movie;    //empty = no movie
+	uint32_t seed = 0;    //random controller 1 input when there's no movie, 0 = none
+};
+
+struct JobResult
+{
+	bool loaded = false;  //the rom could be read and its board is supported
+	bool started = false; //and the movie, if any, could be played
+	uint32_t frames = 0;
+	uint32_t stateHash = 0;
+	int64_t desyncFrame = -1;
+	bool jammed = false;  //the job stopped early on a KIL opcode
+	double seconds = 0;
+};
+
+
+const std::vector<Job> ReadJobs(const std::string &jobFile, const uint32_t frames, const uint32_t seed);
+const JobResult RunJob(const Job &job);
@@ -0,0 +1,166 @@
+#include <fstream>
+#include <iostream>
+
+#ifdef WINDOWS
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "savefile.hpp"
+
+
+SaveFile::~SaveFile()
+{
+	Unmap();
+}
+
+
+void SaveFile::Resize(const size_t newSize)
+{
+	Unmap();
+	memory.assign(newSize, 0);
+	pData = memory.data();
+	dataSize = newSize;
+}
+
+
+void SaveFile::Copy(const std::string &path, const size_t newSize)
+{
+	Resize(newSize);
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	file.read(reinterpret_cast<char*>(pData), newSize); //a missing or short file leaves the rest zeroed
+}
+
+
+#ifdef WINDOWS
+
+void SaveFile::Map(const std::string &path, const size_t newSize)
+{
+	Unmap();
+
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if(fileHandle != INVALID_HANDLE_VALUE)
+	{
+		//only grows the file, a bigger .sav from another emulator is left alone
+		mappingHandle = CreateFileMappingA(fileHandle, 0, PAGE_READWRITE, 0, newSize, 0);
+		if(mappingHandle)
+		{
+			pData = static_cast<uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, newSize));
+			if(pData)
+			{
+				dataSize = newSize;
+				mapped = true;
+				return;
+			}
+			CloseHandle(mappingHandle);
+		}
+		CloseHandle(fileHandle);
+	}
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+
+	std::cout << "Could not map " << path << ", battery ram will not be saved\n";
+	Resize(newSize);
+}
+
+
+void SaveFile::Sync(const bool wait)
+{
+	if(mapped)
+	{
+		FlushViewOfFile(pData, dataSize);
+		if(wait)
+		{
+			FlushFileBuffers(fileHandle);
+		}
+	}
+}
+
+
+void SaveFile::Unmap()
+{
+	if(mapped)
+	{
+		Sync(true);
+		UnmapViewOfFile(pData);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+		mapped = false;
+	}
+	pData = nullptr;
+	dataSize = 0;
+}
+
+#else
+
+void SaveFile::Map(const std::string &path, const size_t newSize)
+{
+	Unmap();
+
+	fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd != -1)
+	{
+		struct stat fileStat;
+		//only grows the file, a bigger .sav from another emulator is left alone
+		if(!fstat(fd, &fileStat) && (static_cast<size_t>(fileStat.st_size) >= newSize || !ftruncate(fd, newSize)))
+		{
+			void *p = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if(p != MAP_FAILED)
+			{
+				pData = static_cast<uint8_t*>(p);
+				dataSize = newSize;
+				mapped = true;
+				return;
+			}
+		}
+		close(fd);
+		fd = -1;
+	}
+
+	std::cout << "Could not map " << path << ", battery ram will not be saved\n";
+	Resize(newSize);
+}
+
+
+void SaveFile::Sync(const bool wait)
+{
+	if(mapped)
+	{
+		msync(pData, dataSize, wait ? MS_SYNC : MS_ASYNC);
+	}
+}
+
+
+void SaveFile::Unmap()
+{
+	if(mapped)
+	{
+		Sync(true);
+		munmap(pData, dataSize);
+		close(fd);
+		fd = -1;
+		mapped = false;
+	}
+	pData = nullptr;
+	dataSize = 0;
+}
+
+#endif
+
+
+const std::string SavePath(const std::string &romPath)
+{
+	const size_t dot = romPath.find_last_of('.');
+	const size_t slash = romPath.find_last_of("/\\");
+	if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return romPath + ".sav";
+	}
+	return romPath.substr(0, dot) + ".sav";
+}
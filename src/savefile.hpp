@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+enum BatteryMode : uint8_t {BatteryOff, BatteryCopy, BatteryFile}; //plain ram, the .sav read once and never written, the .sav mapped
+
+
+//prg ram, optionally backed by a memory mapped .sav file for battery carts
+//writes go straight to the page cache, so the file is current even if the emulator dies
+class SaveFile
+{
+	public:
+		SaveFile() = default;
+		SaveFile(const SaveFile&) = delete;
+		SaveFile& operator=(const SaveFile&) = delete;
+		~SaveFile();
+
+		void Resize(const size_t newSize);                        //plain ram, no file
+		void Map(const std::string &path, const size_t newSize); //battery ram, falls back to plain ram on failure
+		void Copy(const std::string &path, const size_t newSize); //plain ram holding what the file has, the file stays as it is
+		void Sync(const bool wait);                              //flush dirty pages to disk
+
+		const bool Mapped() const { return mapped; }
+
+		uint8_t* data() { return pData; }
+		const size_t size() const { return dataSize; }
+
+	private:
+		void Unmap();
+
+		std::vector<uint8_t> memory;
+		uint8_t *pData = nullptr;
+		size_t dataSize = 0;
+		bool mapped = false;
+
+		#ifdef WINDOWS
+		void *fileHandle = nullptr;
+		void *mappingHandle = nullptr;
+		#else
+		int fd = -1;
+		#endif
+};
+
+
+const std::string SavePath(const std::string &romPath);
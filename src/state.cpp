@@ -0,0 +1,122 @@
+#include "nes.hpp"
+#include "state.hpp"
+
+
+const uint32_t stateVersion = 5;
+
+
+void Nes::SaveState(std::vector<uint8_t> &buffer)
+{
+	State state(buffer);
+	Serialize(state);
+}
+
+
+bool Nes::LoadState(const std::vector<uint8_t> &buffer)
+{
+	//check the header before touching anything, a size mismatch means it can't be ours either
+	std::array<uint32_t, 5> sha1;
+	uint32_t version;
+	if(buffer.size() != stateSize || buffer.size() < sizeof(sha1) + sizeof(version))
+	{
+		return false;
+	}
+	std::memcpy(sha1.data(), buffer.data(), sizeof(sha1));
+	std::memcpy(&version, buffer.data() + sizeof(sha1), sizeof(version));
+	if(sha1 != romSha1 || version != stateVersion)
+	{
+		return false;
+	}
+
+	State state(buffer);
+	Serialize(state);
+	return state.Valid();
+}
+
+
+void Nes::Serialize(State &state)
+{
+	std::array<uint32_t, 5> sha1 = romSha1;
+	uint32_t version = stateVersion;
+	state.Data(sha1);
+	state.Data(version);
+
+	state.AddRegion(prgRom.data(), prgRom.size());
+	state.AddRegion(prgRam.data(), prgRam.size());
+	state.AddRegion(mmc5.exRam.data(), mmc5.exRam.size());
+	state.AddRegion(mmc5.fill.data(), mmc5.fill.size());
+
+	state.Data(cycleCount);
+	state.Data(PC);
+	state.Data(rA);
+	state.Data(rX);
+	state.Data(rY);
+	state.Data(rS);
+	state.Data(rP);
+	state.Data(addressBus);
+	state.Data(dmaAddress);
+	state.Data(dataBus);
+	ports.Serialize(state);
+	state.Data(cpuRam);
+	state.Block(prgRam.data(), prgRam.size());
+	for(auto &p : pPrgBank)
+	{
+		state.Pointer(p);
+	}
+	for(auto &p : pPrgRamBank)
+	{
+		state.Pointer(p);
+	}
+	state.Data(prgRamEnable);
+	state.Data(prgRamWritable);
+	state.Data(nmi);
+	state.Data(nmiPending);
+	state.Data(irqPending);
+	state.Data(irqScheduler);
+	state.Data(dmaPending);
+	state.Data(dmcDmaActive);
+	state.Data(rw);
+	state.Data(tempData);
+	state.Data(jammed);
+
+	state.Data(vrc4);
+	state.Data(vrcIrq);
+	state.Data(mmc1);
+	state.Data(mmc3);
+	state.Data(mmc5);
+	state.Data(fme7);
+	state.Data(n163);
+
+	ppu.Serialize(state);
+	apu.Serialize(state);
+}
+
+
+const uint32_t Nes::PrgRamHash()
+{
+	return StateHash(prgRam.data(), prgRam.size());
+}
+
+
+const bool Nes::BatteryMapped() const
+{
+	return prgRam.Mapped();
+}
+
+
+const uint32_t StateHash(const uint8_t *data, const size_t size) //fnv-1a over 32 bit words, only has to catch desyncs
+{
+	uint32_t hash = 2166136261;
+	size_t x = 0;
+	for(; x + 4 <= size; x += 4)
+	{
+		uint32_t word;
+		std::memcpy(&word, data + x, 4);
+		hash = (hash ^ word) * 16777619;
+	}
+	for(; x < size; ++x)
+	{
+		hash = (hash ^ data[x]) * 16777619;
+	}
+	return hash;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+//walks the same member list for saving and loading, so every component describes its state once
+class State
+{
+	public:
+		State(std::vector<uint8_t> &output) : output(&output), input(output), loading(false) { output.clear(); }
+		State(const std::vector<uint8_t> &input) : output(nullptr), input(input), loading(true) {}
+
+		template<typename T>
+		void Data(T &value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "only plain data can be copied into a state");
+			Block(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+		}
+
+		void Block(uint8_t *data, const size_t size)
+		{
+			if(loading)
+			{
+				if(position + size > input.size())
+				{
+					valid = false;
+					return;
+				}
+				std::memcpy(data, input.data() + position, size);
+			}
+			else
+			{
+				output->resize(position + size);
+				std::memcpy(output->data() + position, data, size);
+			}
+			position += size;
+		}
+
+		//pointers into banked memory are stored as region + offset, anything unknown comes back as null
+		void AddRegion(uint8_t *data, const size_t size)
+		{
+			regions.push_back({data, size});
+		}
+
+		template<typename T>
+		void Pointer(T *&pointer)
+		{
+			uint32_t encoded = 0xFFFFFFFF;
+			if(!loading)
+			{
+				const uint8_t *p = reinterpret_cast<const uint8_t*>(pointer);
+				for(uint8_t x = 0; x < regions.size(); ++x)
+				{
+					if(p >= regions[x].data && p < regions[x].data + regions[x].size)
+					{
+						encoded = x << 24 | uint32_t(p - regions[x].data);
+						break;
+					}
+				}
+			}
+			Data(encoded);
+			if(loading)
+			{
+				const uint8_t region = encoded >> 24;
+				const uint32_t offset = encoded & 0xFFFFFF;
+				pointer = (region < regions.size() && offset < regions[region].size) ? reinterpret_cast<T*>(regions[region].data + offset) : nullptr;
+			}
+		}
+
+		const bool Loading() const { return loading; }
+		const bool Valid() const { return valid && (!loading || position == input.size()); }
+
+	private:
+		struct Region
+		{
+			uint8_t *data;
+			size_t size;
+		};
+
+		std::vector<uint8_t> *output;
+		const std::vector<uint8_t> &input;
+		std::vector<Region> regions;
+		size_t position = 0;
+		const bool loading;
+		bool valid = true;
+};
+
+
+//structs are copied into states whole, padding included, so zero it once for
+//identical machines to give identical states. restores the default member initialisers
+template<typename T>
+void ClearPadding(T &value)
+{
+	static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value, "only plain data can be cleared");
+	std::memset(static_cast<void*>(&value), 0, sizeof(T));
+	new(&value) T;
+}
+
+
+const uint32_t StateHash(const uint8_t *data, const size_t size);
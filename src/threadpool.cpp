@@ -0,0 +1,114 @@
+#include "threadpool.hpp"
+
+
+ThreadPool::ThreadPool(const unsigned threads)
+{
+	const unsigned count = threads ? threads : 1;
+	for(unsigned x = 0; x < count; ++x)
+	{
+		queues.emplace_back(new Queue);
+	}
+	for(unsigned x = 0; x < count; ++x)
+	{
+		workers.emplace_back(&ThreadPool::Worker, this, x);
+	}
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	wake.notify_all();
+	for(auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	unsigned target;
+	{
+		//counted before it's visible, so a worker can't see it gone before it arrived
+		std::lock_guard<std::mutex> lock(mutex);
+		++queued;
+		++pending;
+		target = nextQueue;
+		nextQueue = (nextQueue + 1) % queues.size();
+	}
+	{
+		std::lock_guard<std::mutex> lock(queues[target]->mutex);
+		queues[target]->tasks.push_back(std::move(task));
+	}
+	wake.notify_one();
+}
+
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]{ return pending == 0; });
+}
+
+
+const unsigned ThreadPool::Size() const
+{
+	return workers.size();
+}
+
+
+void ThreadPool::Worker(const unsigned id)
+{
+	while(true)
+	{
+		std::function<void()> task;
+		if(Pop(id, task))
+		{
+			task();
+			std::lock_guard<std::mutex> lock(mutex);
+			if(--pending == 0)
+			{
+				done.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [this]{ return stop || queued; });
+		if(stop && !queued)
+		{
+			return;
+		}
+	}
+}
+
+
+bool ThreadPool::Pop(const unsigned id, std::function<void()> &task)
+{
+	for(unsigned x = 0; x < queues.size(); ++x)
+	{
+		Queue &queue = *queues[(id + x) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(!queue.tasks.empty())
+		{
+			if(x == 0) //own work newest first, stolen work oldest first
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			std::lock_guard<std::mutex> countLock(mutex);
+			--queued;
+			return true;
+		}
+	}
+	return false;
+}
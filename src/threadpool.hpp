@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//every worker owns a queue and takes from its back, idle workers steal from the front of the others
+class ThreadPool
+{
+	public:
+		ThreadPool(const unsigned threads);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		void Submit(std::function<void()> task); //spread round robin over the worker queues
+		void Wait();                             //until every submitted task has finished
+		const unsigned Size() const;
+
+	private:
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		void Worker(const unsigned id);
+		bool Pop(const unsigned id, std::function<void()> &task);
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable wake, done;
+		size_t queued = 0;  //sitting in a queue
+		size_t pending = 0; //submitted but not finished
+		unsigned nextQueue = 0;
+		bool stop = false;
+};
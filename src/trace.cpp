@@ -0,0 +1,180 @@
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "trace.hpp"
+
+
+enum AddressMode : uint8_t {Imp, Acc, Imm, Zp, Zpx, Zpy, Abs, Abx, Aby, Ind, Izx, Izy, Rel};
+
+const std::array<const char*, 256> opName //nestest's names, isb for isc
+{{
+	"BRK","ORA","KIL","SLO","NOP","ORA","ASL","SLO","PHP","ORA","ASL","ANC","NOP","ORA","ASL","SLO",
+	"BPL","ORA","KIL","SLO","NOP","ORA","ASL","SLO","CLC","ORA","NOP","SLO","NOP","ORA","ASL","SLO",
+	"JSR","AND","KIL","RLA","BIT","AND","ROL","RLA","PLP","AND","ROL","ANC","BIT","AND","ROL","RLA",
+	"BMI","AND","KIL","RLA","NOP","AND","ROL","RLA","SEC","AND","NOP","RLA","NOP","AND","ROL","RLA",
+	"RTI","EOR","KIL","SRE","NOP","EOR","LSR","SRE","PHA","EOR","LSR","ALR","JMP","EOR","LSR","SRE",
+	"BVC","EOR","KIL","SRE","NOP","EOR","LSR","SRE","CLI","EOR","NOP","SRE","NOP","EOR","LSR","SRE",
+	"RTS","ADC","KIL","RRA","NOP","ADC","ROR","RRA","PLA","ADC","ROR","ARR","JMP","ADC","ROR","RRA",
+	"BVS","ADC","KIL","RRA","NOP","ADC","ROR","RRA","SEI","ADC","NOP","RRA","NOP","ADC","ROR","RRA",
+	"NOP","STA","NOP","SAX","STY","STA","STX","SAX","DEY","NOP","TXA","XAA","STY","STA","STX","SAX",
+	"BCC","STA","KIL","AHX","STY","STA","STX","SAX","TYA","STA","TXS","TAS","SHY","STA","SHX","AHX",
+	"LDY","LDA","LDX","LAX","LDY","LDA","LDX","LAX","TAY","LDA","TAX","LAX","LDY","LDA","LDX","LAX",
+	"BCS","LDA","KIL","LAX","LDY","LDA","LDX","LAX","CLV","LDA","TSX","LAS","LDY","LDA","LDX","LAX",
+	"CPY","CMP","NOP","DCP","CPY","CMP","DEC","DCP","INY","CMP","DEX","AXS","CPY","CMP","DEC","DCP",
+	"BNE","CMP","KIL","DCP","NOP","CMP","DEC","DCP","CLD","CMP","NOP","DCP","NOP","CMP","DEC","DCP",
+	"CPX","SBC","NOP","ISB","CPX","SBC","INC","ISB","INX","SBC","NOP","SBC","CPX","SBC","INC","ISB",
+	"BEQ","SBC","KIL","ISB","NOP","SBC","INC","ISB","SED","SBC","NOP","ISB","NOP","SBC","INC","ISB"
+}};
+
+const std::array<AddressMode, 256> opMode
+{{
+	Imp,Izx,Imp,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Acc,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx,
+	Abs,Izx,Imp,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Acc,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx,
+	Imp,Izx,Imp,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Acc,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx,
+	Imp,Izx,Imp,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Acc,Imm,Ind,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx,
+	Imm,Izx,Imm,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Imp,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpy,Zpy,Imp,Aby,Imp,Aby,Abx,Abx,Aby,Aby,
+	Imm,Izx,Imm,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Imp,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpy,Zpy,Imp,Aby,Imp,Aby,Abx,Abx,Aby,Aby,
+	Imm,Izx,Imm,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Imp,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx,
+	Imm,Izx,Imm,Izx,Zp ,Zp ,Zp ,Zp ,Imp,Imm,Imp,Imm,Abs,Abs,Abs,Abs,
+	Rel,Izy,Imp,Izy,Zpx,Zpx,Zpx,Zpx,Imp,Aby,Imp,Aby,Abx,Abx,Abx,Abx
+}};
+
+//the 151 documented opcodes, nestest marks everything else with a *
+const std::array<uint16_t, 16> officialOps
+{{
+	0b1100011011100110, 0b1100011011000110, 0b1100111011101110, 0b1100011011000110,
+	0b1100011011101110, 0b1100011011000110, 0b1100011011101110, 0b1100011011000110,
+	0b0100111010101110, 0b1100111011100100, 0b1110111011101110, 0b1100111011101110,
+	0b1100111011101110, 0b1100011011000110, 0b1100111011101110, 0b1100011011000110
+}};
+
+const std::array<char, 4> traceMagic{{'F', 'T', 'R', 0x1A}};
+const uint32_t traceVersion = 1;
+
+
+Trace::Trace(const size_t capacity) : ring(capacity ? capacity : 1)
+{
+}
+
+
+void Trace::SetPcRange(const uint16_t low, const uint16_t high)
+{
+	pcLow = low;
+	pcHigh = high;
+}
+
+
+void Trace::SetScanlineRange(const uint16_t low, const uint16_t high)
+{
+	scanlineLow = low;
+	scanlineHigh = high;
+}
+
+
+void Trace::Clear()
+{
+	next = 0;
+	wrapped = false;
+}
+
+
+const std::vector<TraceEntry> Trace::Entries() const
+{
+	std::vector<TraceEntry> entries;
+	if(wrapped)
+	{
+		entries.assign(ring.begin() + next, ring.end());
+	}
+	entries.insert(entries.end(), ring.begin(), ring.begin() + next);
+	return entries;
+}
+
+
+bool Trace::Save(const std::string &path) const
+{
+	std::ofstream output(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!output.is_open())
+	{
+		std::cout << "Could not create " << path << std::endl;
+		return false;
+	}
+
+	const std::vector<TraceEntry> entries = Entries();
+	const uint32_t count = entries.size();
+	output.write(traceMagic.data(), traceMagic.size());
+	output.write(reinterpret_cast<const char*>(&traceVersion), sizeof(traceVersion));
+	output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TraceEntry));
+	return output.good();
+}
+
+
+bool LoadTrace(const std::string &path, std::vector<TraceEntry> &entries)
+{
+	std::ifstream input(path.c_str(), std::ios::in | std::ios::binary);
+	std::array<char, 4> magic{};
+	uint32_t version = 0, count = 0;
+	input.read(magic.data(), magic.size());
+	input.read(reinterpret_cast<char*>(&version), sizeof(version));
+	input.read(reinterpret_cast<char*>(&count), sizeof(count));
+	if(!input.good() || magic != traceMagic || version != traceVersion)
+	{
+		std::cout << path << " is not a trace" << std::endl;
+		return false;
+	}
+
+	entries.resize(count);
+	input.read(reinterpret_cast<char*>(entries.data()), count * sizeof(TraceEntry));
+	entries.resize(input.gcount() / sizeof(TraceEntry)); //keep what's there of a truncated file
+	return true;
+}
+
+
+void WriteTraceLog(const std::vector<TraceEntry> &entries, std::ostream &out)
+{
+	char bytes[16], text[40], line[128];
+	for(const auto &e : entries)
+	{
+		const AddressMode mode = opMode[e.opcode];
+		const uint16_t address = e.op1 | (e.op2 << 8);
+		switch(mode)
+		{
+			case Imp: std::snprintf(text, sizeof(text), "%s", opName[e.opcode]); break;
+			case Acc: std::snprintf(text, sizeof(text), "%s A", opName[e.opcode]); break;
+			case Imm: std::snprintf(text, sizeof(text), "%s #$%02X", opName[e.opcode], e.op1); break;
+			case Zp:  std::snprintf(text, sizeof(text), "%s $%02X", opName[e.opcode], e.op1); break;
+			case Zpx: std::snprintf(text, sizeof(text), "%s $%02X,X", opName[e.opcode], e.op1); break;
+			case Zpy: std::snprintf(text, sizeof(text), "%s $%02X,Y", opName[e.opcode], e.op1); break;
+			case Abs: std::snprintf(text, sizeof(text), "%s $%04X", opName[e.opcode], address); break;
+			case Abx: std::snprintf(text, sizeof(text), "%s $%04X,X", opName[e.opcode], address); break;
+			case Aby: std::snprintf(text, sizeof(text), "%s $%04X,Y", opName[e.opcode], address); break;
+			case Ind: std::snprintf(text, sizeof(text), "%s ($%04X)", opName[e.opcode], address); break;
+			case Izx: std::snprintf(text, sizeof(text), "%s ($%02X,X)", opName[e.opcode], e.op1); break;
+			case Izy: std::snprintf(text, sizeof(text), "%s ($%02X),Y", opName[e.opcode], e.op1); break;
+			case Rel: std::snprintf(text, sizeof(text), "%s $%04X", opName[e.opcode], uint16_t(e.pc + 2 + int8_t(e.op1))); break;
+		}
+
+		//brk is listed with one byte like nestest does, its padding byte isn't an operand
+		const uint8_t length = (mode >= Abs && mode <= Ind) ? 3 : (mode == Imp || mode == Acc) ? 1 : 2;
+		switch(length)
+		{
+			case 1: std::snprintf(bytes, sizeof(bytes), "%02X", e.opcode); break;
+			case 2: std::snprintf(bytes, sizeof(bytes), "%02X %02X", e.opcode, e.op1); break;
+			case 3: std::snprintf(bytes, sizeof(bytes), "%02X %02X %02X", e.opcode, e.op1, e.op2); break;
+		}
+
+		const bool official = officialOps[e.opcode >> 4] & (0x8000 >> (e.opcode & 0x0F));
+		std::snprintf(line, sizeof(line), "%04X  %-8s %c%-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X PPU:%3u,%3u CYC:%u\n",
+			e.pc, bytes, official ? ' ' : '*', text, e.a, e.x, e.y, e.p & ~0x10, e.s, e.scanline, e.dot, e.cycle);
+		out << line;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+//one executed instruction, recorded before it runs
+struct TraceEntry
+{
+	uint32_t cycle;
+	uint16_t pc;
+	uint8_t opcode, op1, op2;
+	uint8_t a, x, y, p, s;
+	uint16_t dot, scanline;
+};
+
+
+//binary ring of the last instructions, formatting happens offline so tracing costs a copy per instruction
+class Trace
+{
+	public:
+		Trace(const size_t capacity = 1 << 20);
+
+		void SetPcRange(const uint16_t low, const uint16_t high);
+		void SetScanlineRange(const uint16_t low, const uint16_t high);
+		bool Wants(const uint16_t pc, const uint16_t scanline) const
+		{
+			return pc >= pcLow && pc <= pcHigh && scanline >= scanlineLow && scanline <= scanlineHigh;
+		}
+		void Record(const TraceEntry &entry)
+		{
+			ring[next] = entry;
+			if(++next == ring.size())
+			{
+				next = 0;
+				wrapped = true;
+			}
+		}
+
+		void Clear();
+		const std::vector<TraceEntry> Entries() const; //oldest first
+		bool Save(const std::string &path) const;
+
+	private:
+		std::vector<TraceEntry> ring;
+		size_t next = 0;
+		bool wrapped = false;
+
+		uint16_t pcLow = 0, pcHigh = 0xFFFF;
+		uint16_t scanlineLow = 0, scanlineHigh = 261;
+};
+
+
+bool LoadTrace(const std::string &path, std::vector<TraceEntry> &entries);
+void WriteTraceLog(const std::vector<TraceEntry> &entries, std::ostream &out); //nestest layout, without the memory values
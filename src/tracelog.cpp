@@ -0,0 +1,34 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+
+//offline formatter for traces saved by Trace::Save, the log goes to stdout
+int main(int argc, char* argv[])
+{
+	if(argc != 2 && argc != 4)
+	{
+		std::cout << "nestrace trace.bin [first last]" << std::endl;
+		std::cout << "  writes a nestest style log, optionally only entries first to last" << std::endl;
+		exit(0);
+	}
+
+	std::vector<TraceEntry> entries;
+	if(!LoadTrace(argv[1], entries))
+	{
+		exit(1);
+	}
+	if(argc == 4)
+	{
+		const size_t first = std::min<size_t>(std::stoul(argv[2]), entries.size());
+		const size_t last = std::min<size_t>(std::stoul(argv[3]) + 1, entries.size());
+		entries = std::vector<TraceEntry>(entries.begin() + first, entries.begin() + std::max(first, last));
+	}
+
+	std::ios::sync_with_stdio(false);
+	WriteTraceLog(entries, std::cout);
+	return 0;
+}
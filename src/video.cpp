@@ -0,0 +1,43 @@
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define VIDEO_AVX2 //built for every x86 target, used when the cpu has it
+#endif
+
+#include "video.hpp"
+
+
+static void ExpandLine(const uint32_t *lut, const uint8_t *in, uint32_t *out)
+{
+	for(uint16_t x = 0; x < 256; ++x)
+	{
+		out[x] = lut[in[x]];
+	}
+}
+
+
+#ifdef VIDEO_AVX2
+__attribute__((target("avx2"))) static void ExpandLineAvx2(const uint32_t *lut, const uint8_t *in, uint32_t *out)
+{
+	//8 pixels per gather, the 256 byte lut stays in l1
+	for(uint16_t x = 0; x < 256; x += 8)
+	{
+		const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + x)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), index, 4));
+	}
+}
+#endif
+
+
+void IndexedToRgba(const uint8_t *indices, const uint8_t *lineEmphasis, const uint32_t *paletteLut, uint32_t *output)
+{
+	#ifdef VIDEO_AVX2
+	static void (*const expandLine)(const uint32_t*, const uint8_t*, uint32_t*) = __builtin_cpu_supports("avx2") ? ExpandLineAvx2 : ExpandLine;
+	#else
+	void (*const expandLine)(const uint32_t*, const uint8_t*, uint32_t*) = ExpandLine;
+	#endif
+
+	for(uint16_t y = 0; y < 240; ++y)
+	{
+		expandLine(paletteLut + (lineEmphasis[y] << 6), indices + y * 256, output + y * 256);
+	}
+}
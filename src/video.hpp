@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+
+//expands an indexed ppu frame (Ppu::SetPixelFormat(Indexed)) to rgba using Ppu::GetPaletteLut()
+void IndexedToRgba(const uint8_t *indices, const uint8_t *lineEmphasis, const uint32_t *paletteLut, uint32_t *output);